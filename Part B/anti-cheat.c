@@ -3,9 +3,10 @@
 #include <string.h>  // for strlen, strcmp
 #include <unistd.h>  // for sleep
 #include <zmq.h>     // for zmq_recv, zmq_send, zmq_close, zmq_connect, zmq_...
+#include "endpoints.h"
 
-#define SERVER_ADDRESS "tcp://127.0.0.1:5533"
-#define PUBLISHER_ADDRESS "tcp://127.0.0.1:5554"
+#define DEFAULT_SERVER_ADDRESS "tcp://127.0.0.1:5533"
+#define DEFAULT_PUBLISHER_ADDRESS "tcp://127.0.0.1:5554"
 
 
 #define MSG_CONNECT "Astronaut_connect"
@@ -33,7 +34,7 @@ void run_client() {
     // Initialize ZeroMQ context and socket
     void *context = zmq_ctx_new();
     void *socket = zmq_socket(context, ZMQ_REQ);
-    zmq_connect(socket, SERVER_ADDRESS);
+    zmq_connect(socket, endpoint(ENV_SERVER_ADDRESS, DEFAULT_SERVER_ADDRESS));
 
     // Receive response from the server and extract astronaut ID
     char response[65];  
@@ -20,7 +20,7 @@ void *listen_thread() {
         return NULL;
     }
 
-    if (zmq_connect(subscriber, PUBLISHER_ADDRESS) != 0) {
+    if (zmq_connect(subscriber, endpoint(ENV_PUBLISHER_ADDRESS, DEFAULT_PUBLISHER_ADDRESS)) != 0) {
         perror("Failed to connect ZeroMQ subscriber to publisher");
         zmq_close(subscriber);
         return NULL;
@@ -53,13 +53,83 @@ void *listen_thread() {
 
 
 
+/**
+ * Displays a server response below the welcome banner.
+ *
+ * @param response The response text.
+ */
+void show_response(const char *response) {
+	move(3, 0);	 // move to begining of line
+	clrtoeol();
+	move(4, 0);	 // move to begining of line
+	clrtoeol();
+	mvprintw(3, 0, "%s", response);
+	refresh();
+}
+
+/**
+ * Reads keys and sends commands without waiting for each reply.
+ *
+ * Up to MAX_IN_FLIGHT commands can be outstanding. The socket and the
+ * terminal are polled together, replies are matched to their commands by
+ * sequence number, and keys are left in the terminal buffer while the
+ * pipeline is full. After a disconnection is sent, the client waits at
+ * most REPLY_TIMEOUT_MS for each reply, and stops at the disconnection's.
+ */
+void run_pipelined() {
+	int disconnecting = 0;
+	char response[65];
+	nodelay(stdscr, TRUE);
+
+	while (quit_flag == 0) {
+		zmq_pollitem_t items[] = {{socket, 0, ZMQ_POLLIN, 0}, {NULL, STDIN_FILENO, ZMQ_POLLIN, 0}};
+		int count = (!disconnecting && in_flight.count < MAX_IN_FLIGHT) ? 2 : 1;
+		int ready = zmq_poll(items, count, disconnecting ? REPLY_TIMEOUT_MS : -1);
+		if (ready == -1) break;
+		if (ready == 0) {
+			show_response("No reply from the server");
+			break;
+		}
+
+		if (items[0].revents & ZMQ_POLLIN) {
+			unsigned int seq;
+			if (recv_reply(socket, pipelined, &seq, response, sizeof(response)) == -1) break;
+			char key = complete_command(&in_flight, seq);
+			show_response(response);
+			if (key == 'Q') {
+				if (strcmp(response, "Disconnected") == 0) mvprintw(5, 0, "Thanks for playing! See you soon!");
+				refresh();
+				break;
+			}
+		}
+
+		if (count == 2 && (items[1].revents & ZMQ_POLLIN)) {
+			int ch;
+			while (!disconnecting && in_flight.count < MAX_IN_FLIGHT && (ch = getch()) != ERR) {
+				char message[COMMAND_SIZE];
+				char key = key_command(ch, astronaut_id, token, 0, message);
+				if (!key) continue;
+
+				unsigned int seq = in_flight.next_seq++;
+				if (send_command(socket, pipelined, message, seq) == -1) {
+					quit_flag = 1;
+					break;
+				}
+				track_command(&in_flight, seq, key);
+				if (key == 'Q') disconnecting = 1;
+			}
+		}
+	}
+}
+
 /**
  * Runs the client application, handling user input and server communication.
  *
  * This function initializes the ncurses library for user input and output,
  * sets up a ZeroMQ context and socket to communicate with the server, and
  * processes user commands to send movement or action messages. It displays
- * server responses and handles disconnection gracefully.
+ * server responses and handles disconnection gracefully. In pipelined mode
+ * a DEALER socket is used and commands do not wait for their replies.
  */
 
 void *run_client() {
@@ -68,46 +138,35 @@ void *run_client() {
 	initscr();
 	keypad(stdscr, TRUE);
 	noecho();
-	socket = zmq_socket(context, ZMQ_REQ);
-	int rc = zmq_connect(socket, SERVER_ADDRESS);
+	socket = zmq_socket(context, pipelined ? ZMQ_DEALER : ZMQ_REQ);
+	int rc = zmq_connect(socket, endpoint(ENV_SERVER_ADDRESS, DEFAULT_SERVER_ADDRESS));
 	assert(rc == 0);
 	// Connect to the server
-	zmq_send(socket, MSG_CONNECT, strlen(MSG_CONNECT), 0);
+	send_command(socket, pipelined, MSG_CONNECT, 0);
 
 	// Receive response from the server and extract astronaut ID
 	char response[65];
-	int bytes = zmq_recv(socket, response, sizeof(response), 0);
-	response[bytes] = '\0';
+	unsigned int seq;
+	recv_reply(socket, pipelined, &seq, response, sizeof(response));
 
 	sscanf(response, "Welcome! You are player %c %s", &astronaut_id, token);
 	mvprintw(1, 0, "Welcome! You are player %c", astronaut_id);	 // Display the response
 	mvprintw(2, 0, "- - - - - - - - - - - - - - - - -");	// Display the response
 	refresh();
 
-	while (quit_flag == 0) {
+	if (pipelined) run_pipelined();
+
+	while (!pipelined && quit_flag == 0) {
 		int ch = getch();
 
 		// Prepare the movement message based on key press
-		char message[38];
-		if (ch == KEY_UP) sprintf(message, "%s %c %c %s", MSG_MOVE, astronaut_id, 'U', token);
-		else if (ch == KEY_DOWN) sprintf(message, "%s %c %c %s", MSG_MOVE, astronaut_id, 'D', token);
-		else if (ch == KEY_LEFT) sprintf(message, "%s %c %c %s", MSG_MOVE, astronaut_id, 'L', token);
-		else if (ch == KEY_RIGHT) sprintf(message, "%s %c %c %s", MSG_MOVE, astronaut_id, 'R', token);
-		else if (ch == ' ') sprintf(message, "%s %c %s", MSG_ZAP, astronaut_id, token);
-		else if (ch == 'q' || ch == 'Q') sprintf(message, "%s %c %s", MSG_DISCONNECT, astronaut_id, token);	
-		else continue;  // Skip unrecognized keys
+		char message[COMMAND_SIZE];
+		if (!key_command(ch, astronaut_id, token, 0, message)) continue;  // Skip unrecognized keys
 
 		// Send the message to the server and wait for a response
-		zmq_send(socket, message, strlen(message), 0);
-		bytes = zmq_recv(socket, response, sizeof(response), 0);
-		response[bytes] = '\0';
-		move(3, 0);	 // move to begining of line
-		clrtoeol();
-		move(4, 0);	 // move to begining of line
-		clrtoeol();
-		refresh();
-		mvprintw(3, 0, "%s", response);
-		refresh();
+		send_command(socket, pipelined, message, 0);
+		recv_reply(socket, pipelined, &seq, response, sizeof(response));
+		show_response(response);
 
 		if (strcmp(response, "Disconnected") == 0) {
 			mvprintw(5, 0, "Thanks for playing! See you soon!");
@@ -132,10 +191,15 @@ void *run_client() {
  * This function initializes and runs the client application
  * by calling the `run_client` function. After execution,
  * it prints a message indicating the client has finished.
+ * Passing --pipelined enables the DEALER-based pipelined protocol.
  *
  * @return Returns 0 upon successful completion.
  */
-int main() {
+int main(int argc, char *argv[]) {
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--pipelined") == 0) pipelined = 1;
+    }
+
     context = zmq_ctx_new();
     if (!context) {
         fprintf(stderr, "Error creating ZeroMQ context: %s\n", zmq_strerror(errno));
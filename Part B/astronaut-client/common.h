@@ -7,16 +7,13 @@
 #include <string.h>
 #include <unistd.h>	 // for sleep
 #include <zmq.h>	 // for zmq_recv, zmq_send, zmq_close, zmq_connect, zmq_...
+#include "../endpoints.h"
+#include "../astronaut-commands.h"
 #include <pthread.h> // for pthread_create, pthread_join, pthread_mutex_lock, p...
 #include <stdlib.h>	  // for rand, exit, EXIT_FAILURE, EXIT_SUCCESS
 
-#define SERVER_ADDRESS "tcp://127.0.0.1:5533"
-#define PUBLISHER_ADDRESS "tcp://127.0.0.1:5554"
-
-#define MSG_CONNECT "Astronaut_connect"
-#define MSG_DISCONNECT "Astronaut_disconnect"
-#define MSG_MOVE "Astronaut_movement"
-#define MSG_ZAP "Astronaut_zap"
+#define DEFAULT_SERVER_ADDRESS "tcp://127.0.0.1:5533"
+#define DEFAULT_PUBLISHER_ADDRESS "tcp://127.0.0.1:5554"
 
 #define MSG_SERVER "Server_terminate"
 #define MSG_THREAD "Thread_terminate"
@@ -26,6 +23,9 @@ void *context, *socket, *subscriber;
 int pipefd[2];
 
 char astronaut_id;
-char token[6];
+char token[7];
+
+InFlightTable in_flight = {.next_seq = 1}; // Pipelined commands awaiting their reply
+int pipelined = 0; // Use a DEALER socket with sequence-numbered commands
 
 #endif
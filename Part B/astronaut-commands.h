@@ -0,0 +1,158 @@
+#ifndef ASTRONAUT_COMMANDS_H
+#define ASTRONAUT_COMMANDS_H
+
+// Client side of the astronaut command protocol, shared by astronaut-client
+// and astronaut-display-client. Commands are text lines sent on a REQ
+// socket, one reply at a time, or in pipelined mode on a DEALER socket:
+// each command then carries a sequence number (" #<seq>") that the server
+// echoes in a frame before its reply, so up to MAX_IN_FLIGHT commands can
+// be outstanding and their replies matched as they arrive.
+
+#include <curses.h>  // for KEY_UP, KEY_DOWN, KEY_LEFT, KEY_RIGHT
+#include <stdint.h>  // for uint64_t
+#include <stdio.h>   // for sprintf, snprintf
+#include <stdlib.h>  // for strtoul
+#include <string.h>  // for strlen
+#include <zmq.h>     // for zmq_send, zmq_recv, zmq_getsockopt
+
+#define MSG_CONNECT "Astronaut_connect"
+#define MSG_DISCONNECT "Astronaut_disconnect"
+#define MSG_MOVE "Astronaut_movement"
+#define MSG_ZAP "Astronaut_zap"
+
+#define COMMAND_SIZE 48       // Longest command built by key_command, with its terminator
+#define MAX_IN_FLIGHT 16      // Commands awaiting a reply in pipelined mode
+#define REPLY_TIMEOUT_MS 2000 // Wait for a reply before giving up on a command
+
+// Command sent in pipelined mode whose reply has not arrived yet
+typedef struct {
+    unsigned int seq; // 0 if the slot is free
+    char key;         // 'U', 'D', 'L', 'R', 'Z' or 'Q'
+} InFlight;
+
+typedef struct {
+    InFlight commands[MAX_IN_FLIGHT];
+    int count;
+    unsigned int next_seq; // Sequence number of the next command, from 1
+} InFlightTable;
+
+/**
+ * Builds the command message corresponding to a key press.
+ *
+ * @param ch Key code returned by getch.
+ * @param astronaut_id ID of the player's astronaut.
+ * @param token Validation token of the player.
+ * @param tick Tick of the aliens on screen, sent with zaps so the server
+ *             resolves them against what the player saw, 0 for none.
+ * @param message Buffer of COMMAND_SIZE bytes where the command is written.
+ * @return The command letter ('U', 'D', 'L', 'R', 'Z' or 'Q'), or 0 if the
+ *         key is not bound to any command.
+ */
+static inline char key_command(int ch, char astronaut_id, const char *token, uint64_t tick, char *message) {
+    if (ch == KEY_UP) sprintf(message, "%s %c %c %s", MSG_MOVE, astronaut_id, 'U', token);
+    else if (ch == KEY_DOWN) sprintf(message, "%s %c %c %s", MSG_MOVE, astronaut_id, 'D', token);
+    else if (ch == KEY_LEFT) sprintf(message, "%s %c %c %s", MSG_MOVE, astronaut_id, 'L', token);
+    else if (ch == KEY_RIGHT) sprintf(message, "%s %c %c %s", MSG_MOVE, astronaut_id, 'R', token);
+    else if (ch == ' ' && tick) {
+        sprintf(message, "%s %c %s %llu", MSG_ZAP, astronaut_id, token, (unsigned long long)tick);
+    } else if (ch == ' ') sprintf(message, "%s %c %s", MSG_ZAP, astronaut_id, token);
+    else if (ch == 'q' || ch == 'Q') sprintf(message, "%s %c %s", MSG_DISCONNECT, astronaut_id, token);
+    else return 0;
+
+    if (ch == ' ') return 'Z';
+    if (ch == 'q' || ch == 'Q') return 'Q';
+    return message[strlen(MSG_MOVE) + 3];
+}
+
+/**
+ * Sends a command to the server.
+ *
+ * In pipelined mode the DEALER socket must send the empty delimiter frame a
+ * REQ socket would add, and a non-zero sequence number is appended to the
+ * command so the reply can be matched.
+ *
+ * @param socket The REQ or DEALER socket connected to the server.
+ * @param pipelined Set if socket is a DEALER socket.
+ * @param message The command to send.
+ * @param seq Sequence number of the command, 0 for none.
+ * @return Number of bytes sent, or -1 on error.
+ */
+static inline int send_command(void *socket, int pipelined, const char *message, unsigned int seq) {
+    char framed[64];
+    int len = seq ? snprintf(framed, sizeof(framed), "%s #%u", message, seq)
+                  : snprintf(framed, sizeof(framed), "%s", message);
+
+    if (pipelined && zmq_send(socket, "", 0, ZMQ_SNDMORE) == -1) return -1;
+    return zmq_send(socket, framed, len, 0);
+}
+
+/**
+ * Receives a reply from the server.
+ *
+ * Replies to sequenced commands carry the sequence number in a frame
+ * before the text; the empty delimiter frame of DEALER replies is skipped.
+ *
+ * @param socket The REQ or DEALER socket connected to the server.
+ * @param pipelined Set if socket is a DEALER socket.
+ * @param seq Pointer where the sequence number is stored (0 if absent).
+ * @param reply Buffer where the reply text is written.
+ * @param size Size of the reply buffer.
+ * @return Length of the reply, or -1 on error or timeout.
+ */
+static inline int recv_reply(void *socket, int pipelined, unsigned int *seq, char *reply, size_t size) {
+    char frame[65];
+    int more = 0, parts = 0;
+    size_t more_size = sizeof(more);
+
+    *seq = 0;
+    do {
+        int bytes = zmq_recv(socket, frame, sizeof(frame) - 1, 0);
+        if (bytes == -1) return -1;
+        if (bytes > (int)sizeof(frame) - 1) bytes = sizeof(frame) - 1;
+        frame[bytes] = '\0';
+        zmq_getsockopt(socket, ZMQ_RCVMORE, &more, &more_size);
+        if (pipelined && parts == 1 && more) *seq = strtoul(frame, NULL, 10);
+        parts++;
+    } while (more);
+
+    snprintf(reply, size, "%s", frame);
+    return strlen(reply);
+}
+
+/**
+ * Records a command whose reply is still pending.
+ *
+ * @param table The commands in flight.
+ * @param seq Sequence number of the command.
+ * @param key Command letter.
+ */
+static inline void track_command(InFlightTable *table, unsigned int seq, char key) {
+    for (int i = 0; i < MAX_IN_FLIGHT; i++) {
+        if (table->commands[i].seq == 0) {
+            table->commands[i] = (InFlight){seq, key};
+            table->count++;
+            return;
+        }
+    }
+}
+
+/**
+ * Removes a command from the in-flight table when its reply arrives.
+ *
+ * @param table The commands in flight.
+ * @param seq Sequence number carried by the reply.
+ * @return The command letter, or 0 if no command has that sequence number.
+ */
+static inline char complete_command(InFlightTable *table, unsigned int seq) {
+    for (int i = 0; i < MAX_IN_FLIGHT; i++) {
+        if (seq != 0 && table->commands[i].seq == seq) {
+            char key = table->commands[i].key;
+            table->commands[i] = (InFlight){0};
+            table->count--;
+            return key;
+        }
+    }
+    return 0;
+}
+
+#endif
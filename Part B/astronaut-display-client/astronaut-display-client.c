@@ -1,6 +1,302 @@
 #include "common.h"
 
 int quit_flag = 0;  // Global flag to signal quit
+FrameCache frame_cache = {0};  // What the board and score windows show
+
+/**
+ * Applies a movement to a position, following the server's movement rules.
+ *
+ * @param index Astronaut index, which selects the lane limits.
+ * @param direction Movement direction ('U', 'D', 'L' or 'R').
+ * @param x Pointer to the row, updated in place.
+ * @param y Pointer to the column, updated in place.
+ */
+void apply_move(int index, char direction, int *x, int *y) {
+    if (direction == 'U' && *x - 1 >= X_MIN[index]) (*x)--;
+    else if (direction == 'D' && *x + 1 <= X_MAX[index]) (*x)++;
+    else if (direction == 'L' && *y - 1 >= Y_MIN[index]) (*y)--;
+    else if (direction == 'R' && *y + 1 <= Y_MAX[index]) (*y)++;
+}
+
+/**
+ * Returns the character to draw at a board cell.
+ *
+ * The player's own glyph is drawn at its predicted position instead of the
+ * position reported by the last authoritative state.
+ *
+ * @param x Row of the cell.
+ * @param y Column of the cell.
+ * @return The character to draw.
+ */
+char predicted_cell(int x, int y) {
+    char cell = last_state ? snapshot_board(last_state)[x * BOARD_SIZE + y] : ' ';
+    if (prediction_valid) {
+        if (x == predicted_x && y == predicted_y) return astronaut_id;
+        if (cell == astronaut_id) return ' ';
+    }
+    return cell;
+}
+
+/**
+ * Recomputes the predicted position from an authoritative snapshot.
+ *
+ * Moves acknowledged by the server (sequence number up to last_seq) are
+ * discarded and the remaining ones are replayed on top of the server
+ * position, rolling back any misprediction. Must be called with
+ * prediction_mutex held.
+ *
+ * @param snapshot The last authoritative snapshot.
+ */
+void reconcile(const unsigned char *snapshot) {
+    int index = astronaut_id - 'A';
+    unsigned int last_seq = snapshot_player_last_seq(snapshot, index);
+    int kept = 0;
+
+    for (int i = 0; i < pending_count; i++) {
+        if (pending_moves[i].seq > last_seq) pending_moves[kept++] = pending_moves[i];
+    }
+    pending_count = kept;
+
+    predicted_x = snapshot_player_x(snapshot, index);
+    predicted_y = snapshot_player_y(snapshot, index);
+    for (int i = 0; i < pending_count; i++) {
+        apply_move(index, pending_moves[i].direction, &predicted_x, &predicted_y);
+    }
+    prediction_valid = 1;
+}
+
+/**
+ * Redraws the cell the player left and the cell of its predicted position.
+ *
+ * @param old_x Row of the previous predicted position.
+ * @param old_y Column of the previous predicted position.
+ */
+void redraw_prediction(int old_x, int old_y) {
+    render_cell(board_win, &frame_cache, old_x, old_y, predicted_cell(old_x, old_y));
+    render_cell(board_win, &frame_cache, predicted_x, predicted_y, astronaut_id);
+    wrefresh(board_win);
+}
+
+/**
+ * Applies a movement locally as soon as it is sent.
+ *
+ * @param seq Sequence number of the movement command.
+ * @param direction Movement direction.
+ */
+void predict_move(unsigned int seq, char direction) {
+    pthread_mutex_lock(&prediction_mutex);
+    if (pending_count < MAX_IN_FLIGHT) pending_moves[pending_count++] = (PendingMove){seq, direction};
+    if (prediction_valid) {
+        int old_x = predicted_x, old_y = predicted_y;
+        apply_move(astronaut_id - 'A', direction, &predicted_x, &predicted_y);
+        redraw_prediction(old_x, old_y);
+    }
+    pthread_mutex_unlock(&prediction_mutex);
+}
+
+/**
+ * Discards a predicted movement the server rejected and replays the rest.
+ *
+ * @param seq Sequence number of the rejected movement command.
+ */
+void drop_prediction(unsigned int seq) {
+    pthread_mutex_lock(&prediction_mutex);
+    int kept = 0;
+    for (int i = 0; i < pending_count; i++) {
+        if (pending_moves[i].seq != seq) pending_moves[kept++] = pending_moves[i];
+    }
+    pending_count = kept;
+
+    if (prediction_valid) {
+        int old_x = predicted_x, old_y = predicted_y;
+        reconcile(last_state);
+        redraw_prediction(old_x, old_y);
+    }
+    pthread_mutex_unlock(&prediction_mutex);
+}
+/**
+ * Subscribes to the tiles around a tile and unsubscribes from the others.
+ *
+ * Cells of tiles leaving the viewport are blanked, since they no longer
+ * receive updates.
+ *
+ * @param center_row Row of the tile at the center of the viewport.
+ * @param center_col Column of the tile at the center of the viewport.
+ */
+void update_viewport(int center_row, int center_col) {
+    for (int row = 0; row < TILES_PER_SIDE; row++) {
+        for (int col = 0; col < TILES_PER_SIDE; col++) {
+            int wanted = abs(row - center_row) <= VIEWPORT_RADIUS && abs(col - center_col) <= VIEWPORT_RADIUS;
+            if (wanted == tile_subscribed[row][col]) continue;
+
+            char topic[32];
+            int topic_len = snprintf(topic, sizeof(topic), "%s:%02d:%02d", MSG_TILE, row, col);
+            zmq_setsockopt(subscriber, wanted ? ZMQ_SUBSCRIBE : ZMQ_UNSUBSCRIBE, topic, topic_len);
+            tile_subscribed[row][col] = wanted;
+            tile_seq[row][col] = 0;
+            resync_needed |= wanted;
+
+            for (int i = 0; !wanted && i < TILE_SIZE; i++) {
+                memset(&view_board[row * TILE_SIZE + i][col * TILE_SIZE], ' ', TILE_SIZE);
+            }
+        }
+    }
+}
+
+/**
+ * Centers the viewport on the player.
+ *
+ * Until the player's glyph has been seen, the viewport is centered on the
+ * player's lane, or on the board before the player has joined.
+ */
+void follow_player() {
+    int x = BOARD_SIZE / 2, y = BOARD_SIZE / 2;
+    if (own_x >= 0) {
+        x = own_x;
+        y = own_y;
+    } else if (astronaut_id) {
+        int index = astronaut_id - 'A';
+        x = (X_MIN[index] + X_MAX[index]) / 2;
+        y = (Y_MIN[index] + Y_MAX[index]) / 2;
+    }
+    update_viewport(x / TILE_SIZE, y / TILE_SIZE);
+}
+
+/**
+ * Copies a tile update into the local view and looks for the player's glyph.
+ *
+ * Updates older than the snapshot the view was resynced from are dropped,
+ * and a gap in the tile's sequence numbers flags a resync.
+ *
+ * @param tile The received tile record, TILE_RECORD_SIZE(TILE_SIZE) bytes.
+ */
+void apply_tile(const void *tile) {
+    int row = tile_record_row(tile), col = tile_record_col(tile);
+    if (row >= TILES_PER_SIDE || col >= TILES_PER_SIDE || !tile_subscribed[row][col]) {
+        return;
+    }
+    if (tile_record_epoch(tile) == view_epoch && (int)(tile_record_state_seq(tile) - view_seq) <= 0) {
+        return;
+    }
+
+    unsigned int *seq = &tile_seq[row][col];
+    if (*seq && tile_record_seq(tile) != *seq + 1) resync_needed = 1;
+    *seq = tile_record_seq(tile);
+
+    const char *cells = tile_record_cells(tile);
+    for (int i = 0; i < TILE_SIZE; i++) {
+        for (int j = 0; j < TILE_SIZE; j++) {
+            int x = row * TILE_SIZE + i, y = col * TILE_SIZE + j;
+            view_board[x][y] = cells[i * TILE_SIZE + j];
+            if (astronaut_id && cells[i * TILE_SIZE + j] == astronaut_id) {
+                own_x = x;
+                own_y = y;
+            }
+        }
+    }
+}
+
+/**
+ * Refills the subscribed tiles from the server's snapshot endpoint.
+ *
+ * Called when a tile enters the viewport or a tile update was lost, so the
+ * view is complete right away instead of after the next keyframe.
+ */
+void resync_viewport() {
+    resync_needed = 0;
+    if (zmq_send(requester, MSG_SNAPSHOT, strlen(MSG_SNAPSHOT), 0) == -1) return;
+
+    zmq_pollitem_t item = {requester, 0, ZMQ_POLLIN, 0};
+    if (zmq_poll(&item, 1, SNAPSHOT_TIMEOUT_MS) <= 0) return;
+
+    zmq_msg_t reply;
+    zmq_msg_init(&reply);
+    if (zmq_msg_recv(&reply, requester, 0) == -1 ||
+        snapshot_check(zmq_msg_data(&reply), zmq_msg_size(&reply), BOARD_SIZE) != 0) {
+        zmq_msg_close(&reply);
+        return;
+    }
+
+    const unsigned char *snapshot = zmq_msg_data(&reply);
+    const char *board = snapshot_board(snapshot);
+    for (int x = 0; x < BOARD_SIZE; x++) {
+        for (int y = 0; y < BOARD_SIZE; y++) {
+            if (!tile_subscribed[x / TILE_SIZE][y / TILE_SIZE]) continue;
+            view_board[x][y] = board[x * BOARD_SIZE + y];
+            if (astronaut_id && view_board[x][y] == astronaut_id) {
+                own_x = x;
+                own_y = y;
+            }
+        }
+    }
+    memset(tile_seq, 0, sizeof(tile_seq));
+    view_epoch = snapshot_epoch(snapshot);
+    view_seq = snapshot_seq(snapshot);
+    zmq_msg_close(&reply);
+}
+
+/**
+ * Finds the player slot of an ID received in a score message.
+ *
+ * @param id Player ID, a single letter from 'A'.
+ * @return The slot, or -1 if the ID does not name one.
+ */
+int score_slot(const char *id) {
+    int slot = id[0] - 'A';
+    return id[0] && !id[1] && slot >= 0 && slot < MAX_PLAYERS ? slot : -1;
+}
+
+/**
+ * Receives a MSG_SCORES protobuf message and builds the score lines.
+ *
+ * A full message replaces the scores kept by player slot. An incremental
+ * one only holds the players whose score changed and those that left, and
+ * is applied on top of them as long as no version was missed; after a
+ * gap, the scores shown stay as they were until the next full message.
+ *
+ * @param lines Array where the score lines are written.
+ * @return Number of score lines, or -1 on error.
+ */
+int receive_scores(char lines[MAX_PLAYERS][SCORE_LINE_WIDTH + 1]) {
+    uint8_t buffer[1024];
+    int bytes = zmq_recv(subscriber, buffer, sizeof(buffer), 0);
+    if (bytes == -1 || bytes > (int)sizeof(buffer)) return -1;
+
+    SimpleMessage *msg = simple_message__unpack(NULL, bytes, buffer);
+    if (!msg) return -1;
+
+    if (!msg->incremental) {
+        memset(view_score_in_use, 0, sizeof(view_score_in_use));
+        scores_synced = 1;
+    } else if (!scores_synced || msg->version != scores_version + 1) {
+        scores_synced = 0; // Missed an update, wait for the next full message
+    } else {
+        for (size_t i = 0; i < msg->n_left; i++) {
+            int slot = score_slot(msg->left[i]);
+            if (slot != -1) view_score_in_use[slot] = 0;
+        }
+    }
+
+    if (scores_synced) {
+        scores_version = msg->version;
+        for (size_t i = 0; i < msg->n_players; i++) {
+            int slot = score_slot(msg->players[i]->id);
+            if (slot == -1) continue;
+            view_score[slot] = msg->players[i]->score;
+            view_score_in_use[slot] = 1;
+        }
+    }
+    simple_message__free_unpacked(msg, NULL);
+
+    int count = 0;
+    for (int i = 0; i < MAX_PLAYERS; i++) {
+        if (!view_score_in_use[i]) continue;
+        snprintf(lines[count], sizeof(lines[count]), "%c - %d", 'A' + i, view_score[i]);
+        count++;
+    }
+    return count;
+}
+
 /**
  * Displays the current game state in a terminal window using ncurses.
  *
@@ -9,6 +305,11 @@ int quit_flag = 0;  // Global flag to signal quit
  * column numbers, the game board, and player scores. Continuously receives
  * game state updates and refreshes the display accordingly.
  *
+ * In viewport mode only the board tiles around the player are subscribed,
+ * and scores come from MSG_SCORES instead of the full game state. The
+ * view is refilled from the snapshot endpoint whenever tiles enter the
+ * viewport or a tile update is lost.
+ *
  * Cleans up ncurses windows and ZeroMQ resources upon termination.
  */
 void *display_game_state() {
@@ -18,18 +319,40 @@ void *display_game_state() {
         return NULL;
     }
 
-    if (zmq_connect(subscriber, PUBLISHER_ADDRESS) != 0) {
+    if (zmq_connect(subscriber, endpoint(ENV_PUBLISHER_ADDRESS, DEFAULT_PUBLISHER_ADDRESS)) != 0) {
         perror("Failed to connect to ZeroMQ publisher");
         zmq_close(subscriber);
         return NULL;
     }
 
-    if (zmq_setsockopt(subscriber, ZMQ_SUBSCRIBE, MSG_UPDATE, strlen(MSG_UPDATE)) != 0) {
+    if (!viewport && zmq_setsockopt(subscriber, ZMQ_SUBSCRIBE, MSG_UPDATE, strlen(MSG_UPDATE)) != 0) {
         perror("Failed to set ZMQ_SUBSCRIBE option for MSG_UPDATE");
         zmq_close(subscriber);
         return NULL;
     }
 
+    if (viewport) {
+        if (zmq_setsockopt(subscriber, ZMQ_SUBSCRIBE, MSG_SCORES, strlen(MSG_SCORES)) != 0) {
+            perror("Failed to set ZMQ_SUBSCRIBE option for MSG_SCORES");
+            zmq_close(subscriber);
+            return NULL;
+        }
+        // Relaxed, so a request left unanswered does not block the next one
+        int relaxed = 1;
+        requester = zmq_socket(context, ZMQ_REQ);
+        if (!requester ||
+            zmq_setsockopt(requester, ZMQ_REQ_RELAXED, &relaxed, sizeof(relaxed)) != 0 ||
+            zmq_setsockopt(requester, ZMQ_REQ_CORRELATE, &relaxed, sizeof(relaxed)) != 0 ||
+            zmq_connect(requester, endpoint(ENV_SNAPSHOT_ADDRESS, DEFAULT_SNAPSHOT_ADDRESS)) != 0) {
+            perror("Failed to connect to the snapshot endpoint");
+            if (requester) zmq_close(requester);
+            zmq_close(subscriber);
+            return NULL;
+        }
+        memset(view_board, ' ', sizeof(view_board));
+        follow_player();
+    }
+
     if (zmq_setsockopt(subscriber, ZMQ_SUBSCRIBE, MSG_SERVER, strlen(MSG_SERVER)) != 0) {
         perror("Failed to set ZMQ_SUBSCRIBE option for MSG_SERVER");
         zmq_close(subscriber);
@@ -63,7 +386,7 @@ void *display_game_state() {
         return NULL;
     }
 
-    WINDOW *board_win = newwin(BOARD_SIZE + 2, BOARD_SIZE + 2, 2, 2);
+    board_win = newwin(BOARD_SIZE + 2, BOARD_SIZE + 2, 2, 2);
     if (!board_win) {
         perror("Failed to create board_win window");
         delwin(line_win);
@@ -93,58 +416,121 @@ void *display_game_state() {
     box(board_win, 0, 0);
     box(score_win, 0, 0);
 
-    GameState gameState = {0};
+    refresh();
+    wrefresh(line_win);
+    wrefresh(column_win);
+
+    zmq_msg_t incoming;  // Newest snapshot, not drawn yet
+    int incoming_valid = 0;
+    zmq_msg_init(&incoming);
+    zmq_msg_init(&last_state_msg);
+    char score_lines[MAX_PLAYERS][SCORE_LINE_WIDTH + 1];
+    int score_count = 0;
+    int frame_pending = 0;
     char topic[256];
     while (!quit_flag) {
-        if (zmq_recv(subscriber, topic, sizeof(topic), 0) == -1) {
-            break;
-        }
-
-        if (strncmp(topic, MSG_SERVER, strlen(MSG_SERVER)) == 0) {
-            zmq_close(socket);
-            endwin();
-            zmq_close(subscriber);
-            zmq_ctx_destroy(context);
-            exit(0);
-        } else if (strncmp(topic, MSG_UPDATE, strlen(MSG_UPDATE)) != 0) {
-            continue;
+        if (viewport && resync_needed) {
+            resync_viewport();
+            follow_player();
+            frame_pending = 1;
         }
 
-        if (zmq_recv(subscriber, astronaut_ids_in_use, sizeof(astronaut_ids_in_use), 0) == -1) {
-            perror("Failed to receive astronaut IDs");
+        // Wait for the next update, or until a held-back frame is due
+        zmq_pollitem_t item = {subscriber, 0, ZMQ_POLLIN, 0};
+        if (zmq_poll(&item, 1, frame_pending ? frame_delay_ms(&frame_cache) : -1) == -1) {
             break;
         }
 
-        if (zmq_recv(subscriber, &gameState, sizeof(GameState), 0) == -1) {
-            perror("Failed to receive game state");
-            break;
+        if (item.revents & ZMQ_POLLIN) {
+            if (zmq_recv(subscriber, topic, sizeof(topic), 0) == -1) {
+                break;
+            }
+
+            if (strncmp(topic, MSG_SERVER, strlen(MSG_SERVER)) == 0) {
+                if (viewport) zmq_close(requester);
+                zmq_close(socket);
+                endwin();
+                zmq_close(subscriber);
+                zmq_ctx_destroy(context);
+                exit(0);
+            } else if (viewport && strncmp(topic, MSG_TILE, strlen(MSG_TILE)) == 0) {
+                uint8_t tile[TILE_RECORD_SIZE(TILE_SIZE)];
+                int size = zmq_recv(subscriber, tile, sizeof(tile), 0);
+                if (size == -1) {
+                    perror("Failed to receive board tile");
+                    break;
+                }
+                if (size != (int)sizeof(tile)) continue; // Tiles of another size
+                apply_tile(tile);
+                follow_player();
+                frame_pending = 1;
+            } else if (viewport && strncmp(topic, MSG_SCORES, strlen(MSG_SCORES)) == 0) {
+                int count = receive_scores(score_lines);
+                if (count == -1) {
+                    perror("Failed to receive scores");
+                    continue;
+                }
+                score_count = count;
+                frame_pending = 1;
+            } else if (strncmp(topic, MSG_UPDATE, strlen(MSG_UPDATE)) == 0) {
+                // Kept as received: the snapshot is read in place from the message
+                zmq_msg_close(&incoming);
+                zmq_msg_init(&incoming);
+                if (zmq_msg_recv(&incoming, subscriber, 0) == -1) {
+                    perror("Failed to receive game state");
+                    break;
+                }
+                incoming_valid = snapshot_check(zmq_msg_data(&incoming), zmq_msg_size(&incoming), BOARD_SIZE) == 0;
+                frame_pending |= incoming_valid;
+            }
         }
 
-        wclear(score_win);
-        box(score_win, 0, 0);
-        mvwprintw(score_win, 1, 3, "%s", "SCORE");
+        // Frames arriving faster than MAX_FRAME_RATE are coalesced
+        if (!frame_pending || frame_delay_ms(&frame_cache) > 0) {
+            continue;
+        }
+        frame_pending = 0;
+
+        pthread_mutex_lock(&prediction_mutex);
+        char frame[BOARD_SIZE][BOARD_SIZE];
+        if (viewport) {
+            memcpy(frame, view_board, sizeof(frame));
+        } else {
+            if (incoming_valid) {
+                zmq_msg_close(&last_state_msg);
+                zmq_msg_init(&last_state_msg);
+                zmq_msg_move(&last_state_msg, &incoming);
+                last_state = zmq_msg_data(&last_state_msg);
+                view_tick = snapshot_tick(last_state);
+                incoming_valid = 0;
+            }
+            if (pipelined && astronaut_id && last_state && snapshot_player_in_use(last_state, astronaut_id - 'A')) {
+                reconcile(last_state);
+            }
 
-        for (int i = 0; i < BOARD_SIZE; i++) {
-            for (int j = 0; j < BOARD_SIZE; j++) {
-                mvwaddch(board_win, i + 1, j + 1, gameState.board[i][j]);
+            for (int i = 0; i < BOARD_SIZE; i++) {
+                for (int j = 0; j < BOARD_SIZE; j++) {
+                    frame[i][j] = predicted_cell(i, j);
+                }
             }
-        }
 
-        int player_count = 0;
-        for (int i = 0; i < MAX_PLAYERS; i++) {
-            if (astronaut_ids_in_use[i]) {
-                mvwprintw(score_win, 2 + player_count, 3, "%c - %d", gameState.astronauts[i].id, gameState.astronauts[i].score);
-                player_count++;
+            score_count = 0;
+            for (int i = 0; last_state && i < snapshot_slots(last_state) && score_count < MAX_PLAYERS; i++) {
+                if (snapshot_player_in_use(last_state, i)) {
+                    snprintf(score_lines[score_count], sizeof(score_lines[score_count]), "%c - %d",
+                             snapshot_player_id(last_state, i), snapshot_player_score(last_state, i));
+                    score_count++;
+                }
             }
         }
 
-        refresh();
-        wrefresh(board_win);
-        wrefresh(score_win);
-        wrefresh(line_win);
-        wrefresh(column_win);
+        render_board_diff(board_win, &frame_cache, frame);
+        render_scores_diff(score_win, &frame_cache, score_lines, score_count);
+        render_flush(&frame_cache, board_win, score_win);
+        pthread_mutex_unlock(&prediction_mutex);
     }
 
+    if (viewport) zmq_close(requester);
     sleep(2);
     delwin(board_win);
     delwin(score_win);
@@ -154,13 +540,90 @@ void *display_game_state() {
     return NULL;
 }
 
+/**
+ * Returns the tick of the aliens on screen, to aim zaps at.
+ *
+ * @return The tick of the last full state shown, 0 before the first one or
+ *         in viewport mode.
+ */
+uint64_t shown_tick() {
+    pthread_mutex_lock(&prediction_mutex);
+    uint64_t tick = view_tick;
+    pthread_mutex_unlock(&prediction_mutex);
+    return tick;
+}
+
+/**
+ * Reads keys and sends commands without waiting for each reply.
+ *
+ * Up to MAX_IN_FLIGHT commands can be outstanding. The socket and the
+ * terminal are polled together, replies are matched to their commands by
+ * sequence number, and keys are left in the terminal buffer while the
+ * pipeline is full.
+ */
+void run_pipelined() {
+    int disconnecting = 0;
+    char response[65];
+    nodelay(stdscr, TRUE);
+
+    while (!quit_flag || in_flight.count > 0) {
+        zmq_pollitem_t items[] = {{socket, 0, ZMQ_POLLIN, 0}, {NULL, STDIN_FILENO, ZMQ_POLLIN, 0}};
+        int count = (!disconnecting && in_flight.count < MAX_IN_FLIGHT) ? 2 : 1;
+        int ready = zmq_poll(items, count, disconnecting ? REPLY_TIMEOUT_MS : -1);
+        if (ready == -1) {
+            perror("Failed to poll ZeroMQ socket");
+            break;
+        }
+        if (ready == 0) break; // No reply to the disconnection
+
+        if (items[0].revents & ZMQ_POLLIN) {
+            unsigned int seq;
+            if (recv_reply(socket, pipelined, &seq, response, sizeof(response)) == -1) {
+                perror("Failed to receive response from server");
+                break;
+            }
+            char key = complete_command(&in_flight, seq);
+            if (key && strchr("UDLR", key) && strcmp(response, "Move processed") != 0) {
+                drop_prediction(seq);
+            }
+            mvprintw(BOARD_SIZE + 7, 0, "%s", response);
+            clrtoeol();
+            refresh();
+            if (key == 'Q') break;
+        }
+
+        if (count == 2 && (items[1].revents & ZMQ_POLLIN)) {
+            int ch;
+            while (!disconnecting && in_flight.count < MAX_IN_FLIGHT && (ch = getch()) != ERR) {
+                char message[COMMAND_SIZE];
+                char key = key_command(ch, astronaut_id, token, shown_tick(), message);
+                if (!key) continue;
+
+                unsigned int seq = in_flight.next_seq++;
+                if (send_command(socket, pipelined, message, seq) == -1) {
+                    perror("Failed to send message to server");
+                    quit_flag = 1;
+                    break;
+                }
+                track_command(&in_flight, seq, key);
+                if (strchr("UDLR", key)) predict_move(seq, key);
+                if (key == 'Q') {
+                    disconnecting = 1;
+                    quit_flag = 1;
+                }
+            }
+        }
+    }
+}
+
 /**
  * Runs the client application, handling user input and server communication.
  *
  * This function initializes the ncurses library for user input and output,
  * sets up a ZeroMQ context and socket to communicate with the server, and
  * processes user commands to send movement or action messages. It displays
- * server responses and handles disconnection gracefully.
+ * server responses and handles disconnection gracefully. In pipelined mode
+ * a DEALER socket is used and commands do not wait for their replies.
  */
 void *run_client() {
     initscr();
@@ -172,21 +635,29 @@ void *run_client() {
     keypad(stdscr, TRUE);
     noecho();
 
-    socket = zmq_socket(context, ZMQ_REQ);
+    socket = zmq_socket(context, pipelined ? ZMQ_DEALER : ZMQ_REQ);
     if (!socket) {
         perror("Failed to create ZeroMQ socket");
         endwin();
         return NULL;
     }
 
-    if (zmq_connect(socket, SERVER_ADDRESS) != 0) {
+    // A restarting server drops the request it was handling; let the next
+    // command go out instead of waiting forever for that reply
+    int relaxed = 1;
+    if (!pipelined) {
+        zmq_setsockopt(socket, ZMQ_REQ_RELAXED, &relaxed, sizeof(relaxed));
+        zmq_setsockopt(socket, ZMQ_REQ_CORRELATE, &relaxed, sizeof(relaxed));
+    }
+
+    if (zmq_connect(socket, endpoint(ENV_SERVER_ADDRESS, DEFAULT_SERVER_ADDRESS)) != 0) {
         perror("Failed to connect to ZeroMQ server");
         zmq_close(socket);
         endwin();
         return NULL;
     }
 
-    if (zmq_send(socket, MSG_CONNECT, strlen(MSG_CONNECT), 0) == -1) {
+    if (send_command(socket, pipelined, MSG_CONNECT, 0) == -1) {
         perror("Failed to send connection message to server");
         zmq_close(socket);
         endwin();
@@ -194,14 +665,13 @@ void *run_client() {
     }
 
     char response[65];
-    int bytes = zmq_recv(socket, response, sizeof(response), 0);
-    if (bytes == -1) {
+    unsigned int seq;
+    if (recv_reply(socket, pipelined, &seq, response, sizeof(response)) == -1) {
         perror("Failed to receive response from server");
         zmq_close(socket);
         endwin();
         return NULL;
     }
-    response[bytes] = '\0';
 
     if (sscanf(response, "Welcome! You are player %c %s", &astronaut_id, token) != 2) {
         perror("Failed to parse server response");
@@ -214,30 +684,30 @@ void *run_client() {
     mvprintw(BOARD_SIZE + 6, 0, "- - - - - - - - - - - - - - - - -");
     refresh();
 
-    while (!quit_flag) {
+    int timeout = REPLY_TIMEOUT_MS;
+    if (!pipelined) zmq_setsockopt(socket, ZMQ_RCVTIMEO, &timeout, sizeof(timeout));
+
+    if (pipelined) run_pipelined();
+
+    while (!pipelined && !quit_flag) {
         int ch = getch();
-        char message[38];
-        if (ch == KEY_UP) sprintf(message, "%s %c %c %s", MSG_MOVE, astronaut_id, 'U', token);
-        else if (ch == KEY_DOWN) sprintf(message, "%s %c %c %s", MSG_MOVE, astronaut_id, 'D', token);
-        else if (ch == KEY_LEFT) sprintf(message, "%s %c %c %s", MSG_MOVE, astronaut_id, 'L', token);
-        else if (ch == KEY_RIGHT) sprintf(message, "%s %c %c %s", MSG_MOVE, astronaut_id, 'R', token);
-        else if (ch == ' ') sprintf(message, "%s %c %s", MSG_ZAP, astronaut_id, token);
-        else if (ch == 'q' || ch == 'Q') {
-            sprintf(message, "%s %c %s", MSG_DISCONNECT, astronaut_id, token);
-            quit_flag = 1;
-        } else continue;
-
-        if (zmq_send(socket, message, strlen(message), 0) == -1) {
+        char message[COMMAND_SIZE];
+        char key = key_command(ch, astronaut_id, token, shown_tick(), message);
+        if (!key) continue;
+        if (key == 'Q') quit_flag = 1;
+
+        if (send_command(socket, pipelined, message, 0) == -1) {
             perror("Failed to send message to server");
             break;
         }
 
-        bytes = zmq_recv(socket, response, sizeof(response), 0);
-        if (bytes == -1) {
-            perror("Failed to receive response from server");
-            break;
+        if (recv_reply(socket, pipelined, &seq, response, sizeof(response)) == -1) {
+            if (errno != EAGAIN) {
+                perror("Failed to receive response from server");
+                break;
+            }
+            snprintf(response, sizeof(response), "No reply from the server, try again");
         }
-        response[bytes] = '\0';
 
         mvprintw(BOARD_SIZE + 7, 0, "%s", response);
         clrtoeol();
@@ -266,10 +736,17 @@ void *run_client() {
  * This function initializes and runs the client application
  * by calling the `run_client` function. After execution,
  * it prints a message indicating the client has finished.
+ * Passing --pipelined enables the DEALER-based pipelined protocol, and
+ * --viewport subscribes only to the board tiles around the player.
  *
  * @return Returns 0 upon successful completion.
  */
-int main() {
+int main(int argc, char *argv[]) {
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--pipelined") == 0) pipelined = 1;
+        if (strcmp(argv[i], "--viewport") == 0) viewport = 1;
+    }
+
     context = zmq_ctx_new();
     if (!context) {
         perror("Failed to create ZeroMQ context");
@@ -3,6 +3,7 @@
 
 #include <assert.h>  // for assert
 #include <ctype.h>   // for isalnum
+#include <errno.h>   // for errno, EAGAIN
 #include <curses.h>  // for mvwprintw, newwin, wrefresh, mvprintw, WINDOW
 #include <stdio.h>   // for sprintf, perror
 #include <stdlib.h>  // for rand, exit, EXIT_FAILURE, EXIT_SUCCESS
@@ -10,50 +11,40 @@
 #include <time.h>    // for time, time_t
 #include <unistd.h>  // for sleep, NULL, fork, usleep, pid_t
 #include <zmq.h>     // for zmq_send, zmq_close, zmq_ctx_destroy, zmq_socket
+#include "../endpoints.h"
+#include "../astronaut-commands.h"
 #include <pthread.h> // for pthread_create, pthread_join
+#include "../points.pb-c.h"
+#include "../snapshot.h"
 
 
 
-#define SERVER_ADDRESS "tcp://127.0.0.1:5533" // VER ESTES IPS O QUE E PARA POR AQUI
-#define PUBLISHER_ADDRESS "tcp://127.0.0.1:5554"
+#define DEFAULT_SERVER_ADDRESS "tcp://127.0.0.1:5533" // VER ESTES IPS O QUE E PARA POR AQUI
+#define DEFAULT_PUBLISHER_ADDRESS "tcp://127.0.0.1:5554"
+#define DEFAULT_SNAPSHOT_ADDRESS "tcp://127.0.0.1:5569"
+#define SNAPSHOT_TIMEOUT_MS 1000 // Wait for a requested snapshot at most this long
 
 #define BOARD_SIZE 20
 #define MAX_PLAYERS 8
 #define MAX_ALIENS 256
 #define START_ALIENS 85 // 1/3 of the board
+#define TILE_SIZE 5 // Side of the board tiles published on their own topics
+#define TILES_PER_SIDE (BOARD_SIZE / TILE_SIZE)
+#define VIEWPORT_RADIUS 1 // Tiles subscribed around the player's tile in viewport mode
 
 // Message types
-#define MSG_CONNECT "Astronaut_connect"
-#define MSG_DISCONNECT "Astronaut_disconnect"
-#define MSG_MOVE "Astronaut_movement"
-#define MSG_ZAP "Astronaut_zap"
 #define MSG_UPDATE "Outer_space_update"
+#define MSG_TILE "Outer_space_tile"  // Followed by ":RR:CC", one topic per board tile
+#define MSG_SCORES "MSG_SCORES"
+#define MSG_SNAPSHOT "Snapshot_request"
 
 
 #define MSG_SERVER "Server_terminate"
 #define MSG_THREAD "Thread_terminate"
 
-// Structs for astronaut and alien
-typedef struct {
-    char id;
-    int x, y;
-    int score;
-    time_t stunned_time;
-    time_t last_shot_time;
-} Astronaut;
-
-typedef struct {
-    int x, y;
-} Alien;
+#define SNAPSHOT_MAX_SIZE (SNAPSHOT_HEADER_SIZE + MAX_PLAYERS * SNAPSHOT_PLAYER_SIZE + \
+                           BOARD_SIZE * BOARD_SIZE + MAX_ALIENS * SNAPSHOT_ALIEN_SIZE)
 
-// Shared game state
-typedef struct {
-    Astronaut astronauts[MAX_PLAYERS];
-    Alien aliens[MAX_ALIENS];
-    char board[BOARD_SIZE][BOARD_SIZE];
-    int astronaut_count;
-    int alien_count;
-} GameState;
 
 // Constants for X and Y limits for regions
 int Y_MAX[] = {0, 1, 18, 19, 17, 17, 17, 17};
@@ -61,12 +52,44 @@ int Y_MIN[] = {0, 1, 18, 19, 2, 2, 2, 2};
 int X_MAX[] = {17, 17, 17, 17, 0, 1, 18, 19};
 int X_MIN[] = {2, 2, 2, 2, 0, 1, 18, 19};
 
-// Array para verificar quais IDs estão em uso (de 'A' a 'H')
-int astronaut_ids_in_use[MAX_PLAYERS] = {0};  // 0: disponível, 1: em uso
-
 void *context, *socket, *subscriber;
 
 char astronaut_id;
-char token[6];
+char token[7];
+
+InFlightTable in_flight = {.next_seq = 1}; // Pipelined commands awaiting their reply
+int pipelined = 0; // Use a DEALER socket with sequence-numbered commands
+
+// Movement applied locally but not yet acknowledged by the server
+typedef struct {
+    unsigned int seq;
+    char direction;
+} PendingMove;
+
+// Client-side prediction of the player's own position (pipelined mode only)
+PendingMove pending_moves[MAX_IN_FLIGHT];
+int pending_count = 0;
+int predicted_x, predicted_y;
+int prediction_valid = 0;  // Set once the first authoritative state is received
+zmq_msg_t last_state_msg;  // Message holding the last authoritative snapshot
+const unsigned char *last_state = NULL;  // That snapshot, read in place
+uint64_t view_tick = 0;  // Alien tick of last_state, sent with zaps; 0 in viewport mode
+WINDOW *board_win;
+pthread_mutex_t prediction_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+// Area-of-interest view built from tile topics (viewport mode only)
+int viewport = 0;
+char view_board[BOARD_SIZE][BOARD_SIZE];
+int tile_subscribed[TILES_PER_SIDE][TILES_PER_SIDE];
+int own_x = -1, own_y = -1;  // Last cell where the player's glyph was seen
+unsigned int tile_seq[TILES_PER_SIDE][TILES_PER_SIDE];  // Last update of each tile, 0 after a resync
+uint32_t view_epoch = 0, view_seq = 0;  // Snapshot the view was last resynced from
+int resync_needed = 0;  // A tile entered the viewport or an update was lost
+void *requester;  // REQ socket to the snapshot endpoint
+int view_score[MAX_PLAYERS], view_score_in_use[MAX_PLAYERS];  // Scores by player slot, from MSG_SCORES
+uint32_t scores_version = 0;  // Version of the last score message applied
+int scores_synced = 0;  // A full score message was applied and no version missed since
+
+#include "../board-renderer.h"
 
 #endif
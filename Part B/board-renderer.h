@@ -0,0 +1,144 @@
+#ifndef BOARD_RENDERER_H
+#define BOARD_RENDERER_H
+
+// Dirty-region renderer shared by the display programs. Include after the
+// program's common.h, which defines BOARD_SIZE and MAX_PLAYERS.
+
+#include <curses.h>  // for mvwaddch, mvwprintw, wnoutrefresh, doupdate, WINDOW
+#include <stdint.h>  // for uint64_t
+#include <stdio.h>   // for snprintf
+#include <string.h>  // for memcmp, memcpy, strcmp
+#include <time.h>    // for clock_gettime
+
+#define MAX_FRAME_RATE 30    // Frames drawn per second at most
+#define SCORE_LINE_WIDTH (BOARD_SIZE - 2)  // Characters between the score window borders
+
+// What is currently on screen, so only the differences get drawn
+typedef struct {
+    char board[BOARD_SIZE][BOARD_SIZE];
+    char scores[MAX_PLAYERS][SCORE_LINE_WIDTH + 1];
+    int valid;          // 0 until the first frame has been drawn
+    double last_frame;  // Monotonic time of the last frame, in seconds
+} FrameCache;
+
+/**
+ * Returns the current time of the monotonic clock in seconds.
+ *
+ * @return Monotonic time in seconds.
+ */
+static inline double renderer_now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+ * Returns how long to wait before the next frame may be drawn.
+ *
+ * @param cache Pointer to the FrameCache of the display.
+ * @return Milliseconds until the next frame is due, 0 if it is due now.
+ */
+static inline long frame_delay_ms(FrameCache *cache) {
+    double wait = cache->last_frame + 1.0 / MAX_FRAME_RATE - renderer_now();
+    return wait > 0 ? (long)(wait * 1000) + 1 : 0;
+}
+
+/**
+ * Draws a single board cell and records it in the cache.
+ *
+ * @param win Board window, with a one-cell border.
+ * @param cache Pointer to the FrameCache of the display.
+ * @param x Row of the cell.
+ * @param y Column of the cell.
+ * @param ch Character to draw.
+ */
+static inline void render_cell(WINDOW *win, FrameCache *cache, int x, int y, char ch) {
+    cache->board[x][y] = ch;
+    mvwaddch(win, x + 1, y + 1, ch);
+}
+
+/**
+ * Draws the board cells that differ from the previous frame.
+ *
+ * Rows are compared with memcmp first, then changed rows are scanned a
+ * machine word at a time so unchanged runs are skipped without per-cell
+ * work.
+ *
+ * @param win Board window, with a one-cell border.
+ * @param cache Pointer to the FrameCache of the display.
+ * @param board The new frame.
+ * @return Number of cells drawn.
+ */
+static inline int render_board_diff(WINDOW *win, FrameCache *cache, const char board[BOARD_SIZE][BOARD_SIZE]) {
+    int drawn = 0;
+
+    for (int i = 0; i < BOARD_SIZE; i++) {
+        if (cache->valid && memcmp(cache->board[i], board[i], BOARD_SIZE) == 0) continue;
+
+        int j = 0;
+        for (; cache->valid && j + 8 <= BOARD_SIZE; j += 8) {
+            uint64_t before, after;
+            memcpy(&before, &cache->board[i][j], sizeof(before));
+            memcpy(&after, &board[i][j], sizeof(after));
+            if (before == after) continue;
+
+            for (int k = j; k < j + 8; k++) {
+                if (cache->board[i][k] != board[i][k]) {
+                    render_cell(win, cache, i, k, board[i][k]);
+                    drawn++;
+                }
+            }
+        }
+        for (; j < BOARD_SIZE; j++) {
+            if (!cache->valid || cache->board[i][j] != board[i][j]) {
+                render_cell(win, cache, i, j, board[i][j]);
+                drawn++;
+            }
+        }
+    }
+    return drawn;
+}
+
+/**
+ * Draws the score lines that differ from the previous frame.
+ *
+ * Lines are padded to the window width so shorter lines erase longer
+ * ones without clearing the window.
+ *
+ * @param win Score window, with the title on its first line.
+ * @param cache Pointer to the FrameCache of the display.
+ * @param lines The score lines of the new frame.
+ * @param count Number of lines in use.
+ * @return Number of lines drawn.
+ */
+static inline int render_scores_diff(WINDOW *win, FrameCache *cache, char lines[MAX_PLAYERS][SCORE_LINE_WIDTH + 1],
+                                     int count) {
+    int drawn = 0;
+
+    for (int i = 0; i < MAX_PLAYERS; i++) {
+        const char *line = i < count ? lines[i] : "";
+        if (cache->valid && strcmp(cache->scores[i], line) == 0) continue;
+
+        snprintf(cache->scores[i], sizeof(cache->scores[i]), "%s", line);
+        mvwprintw(win, 2 + i, 3, "%-*s", SCORE_LINE_WIDTH, line);
+        drawn++;
+    }
+    return drawn;
+}
+
+/**
+ * Flushes the changed windows to the terminal in a single update.
+ *
+ * @param cache Pointer to the FrameCache of the display.
+ * @param board_win Board window.
+ * @param score_win Score window.
+ */
+static inline void render_flush(FrameCache *cache, WINDOW *board_win, WINDOW *score_win) {
+    wnoutrefresh(board_win);
+    wnoutrefresh(score_win);
+    doupdate();
+    cache->valid = 1;
+    cache->last_frame = renderer_now();
+}
+
+#endif
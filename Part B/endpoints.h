@@ -0,0 +1,64 @@
+#ifndef ENDPOINTS_H
+#define ENDPOINTS_H
+
+// Runtime-configurable ZeroMQ endpoints shared by every program. The
+// DEFAULT_*_ADDRESS macros in the programs are only fallbacks; the
+// environment variables below override them with any transport ZeroMQ
+// supports (tcp://, ipc:// for co-located processes, inproc:// inside one
+// process).
+
+#include <stdlib.h>  // for getenv
+#include <string.h>  // for strchr, strlen, memcpy
+#include <zmq.h>     // for zmq_bind, zmq_connect
+
+#define ENV_SERVER_ADDRESS "SPACE_SERVER_ADDRESS"
+#define ENV_PUBLISHER_ADDRESS "SPACE_PUBLISHER_ADDRESS"
+#define ENV_PULL_ADDRESS "SPACE_PULL_ADDRESS"
+#define ENV_PUSH_ADDRESS "SPACE_PUSH_ADDRESS"
+#define ENV_SNAPSHOT_ADDRESS "SPACE_SNAPSHOT_ADDRESS"
+#define ENV_AGGREGATE_ADDRESS "SPACE_AGGREGATE_ADDRESS"
+#define ENV_QUERY_ADDRESS "SPACE_QUERY_ADDRESS"
+#define ENV_REPLICATION_ADDRESS "SPACE_REPLICATION_ADDRESS"
+
+// Always bound by the game server for components embedded in its process
+#define INPROC_SERVER_ADDRESS "inproc://space-server"
+#define INPROC_PUBLISHER_ADDRESS "inproc://space-publisher"
+
+/**
+ * Returns the endpoint configured in an environment variable.
+ *
+ * @param variable Name of the environment variable.
+ * @param fallback Endpoint used when the variable is unset or empty.
+ * @return The configured endpoint, or the fallback.
+ */
+static inline const char *endpoint(const char *variable, const char *fallback) {
+    const char *value = getenv(variable);
+    return value && *value ? value : fallback;
+}
+
+/**
+ * Binds or connects a socket to every endpoint of a comma-separated list.
+ *
+ * @param socket ZeroMQ socket.
+ * @param list Comma-separated list of endpoints.
+ * @param bind Non-zero to bind, zero to connect.
+ * @return 0 on success, -1 if any endpoint failed.
+ */
+static inline int attach_endpoints(void *socket, const char *list, int bind) {
+    while (*list) {
+        const char *comma = strchr(list, ',');
+        size_t length = comma ? (size_t)(comma - list) : strlen(list);
+        char address[256];
+        if (length >= sizeof(address)) return -1;
+
+        memcpy(address, list, length);
+        address[length] = '\0';
+        if (length > 0 && (bind ? zmq_bind(socket, address) : zmq_connect(socket, address)) != 0) {
+            return -1;
+        }
+        list += comma ? length + 1 : length;
+    }
+    return 0;
+}
+
+#endif
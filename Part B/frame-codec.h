@@ -0,0 +1,255 @@
+#ifndef FRAME_CODEC_H
+#define FRAME_CODEC_H
+
+// Compressed encodings of the state stream. A compressed frame carries the
+// same payload as MSG_LATEST without its topic: a snapshot.h snapshot.
+// Subscribers advertise the codecs they support by subscribing to
+// MSG_COMPRESSED followed by the codec name, and the server encodes each
+// state once for every codec that has a subscriber.
+//
+// The RLE codec is always available. The zstd codec needs libzstd (build
+// with ZSTD=1) and can use a dictionary trained with `zstd --train` on
+// captured payloads; publisher and subscribers must load the same file from
+// SPACE_ZSTD_DICTIONARY. Usable from C and C++.
+
+#include <stdint.h>  // for uint8_t
+#include <stdio.h>   // for fopen, fread, fclose
+#include <stdlib.h>  // for getenv, malloc, free
+#include <string.h>  // for memcmp, memcpy, memset, strlen
+#ifdef HAVE_ZSTD
+#include <zstd.h>    // for ZSTD_compress_usingCDict, ZSTD_decompress_usingDDict
+#endif
+
+#define MSG_COMPRESSED "Outer_space_z/"  // Followed by the codec name
+#define ENV_ZSTD_DICTIONARY "SPACE_ZSTD_DICTIONARY"
+#define ZSTD_LEVEL 3
+#define CODEC_MAX_DICTIONARY (112 * 1024)  // zstd --train's default size
+
+typedef enum { CODEC_RLE, CODEC_ZSTD, CODEC_COUNT } FrameCodec;
+
+static const char *const codec_names[CODEC_COUNT] = {"rle", "zstd"};
+
+// Per-process compression state, set up once by codec_init
+typedef struct {
+#ifdef HAVE_ZSTD
+    ZSTD_CCtx *cctx;
+    ZSTD_DCtx *dctx;
+    ZSTD_CDict *cdict;  // NULL without a dictionary
+    ZSTD_DDict *ddict;
+#endif
+    int dictionary;  // Non-zero if a dictionary was loaded
+} CodecContext;
+
+/**
+ * Looks up a codec by name.
+ *
+ * @param name Codec name, not necessarily NUL-terminated.
+ * @param length Length of the name.
+ * @return The codec, or -1 if the name is unknown.
+ */
+static inline int codec_lookup(const char *name, size_t length) {
+    for (int codec = 0; codec < CODEC_COUNT; codec++) {
+        if (strlen(codec_names[codec]) == length && memcmp(codec_names[codec], name, length) == 0) {
+            return codec;
+        }
+    }
+    return -1;
+}
+
+/**
+ * Tells whether a codec was built into this program.
+ *
+ * @param codec The codec.
+ * @return Non-zero if frames can be encoded and decoded with it.
+ */
+static inline int codec_available(int codec) {
+#ifdef HAVE_ZSTD
+    return codec == CODEC_RLE || codec == CODEC_ZSTD;
+#else
+    return codec == CODEC_RLE;
+#endif
+}
+
+/**
+ * Returns the largest encoded size of a payload, for any codec.
+ *
+ * @param size Size of the payload.
+ * @return Capacity an encoding buffer needs.
+ */
+static inline size_t codec_bound(size_t size) {
+    size_t bound = size + size / 128 + 1;  // RLE: one header per 128 literal bytes
+#ifdef HAVE_ZSTD
+    if (ZSTD_compressBound(size) > bound) bound = ZSTD_compressBound(size);
+#endif
+    return bound;
+}
+
+/**
+ * Sets up the compression state, loading the zstd dictionary if configured.
+ *
+ * @param ctx Pointer to the CodecContext to be set up.
+ * @return 0 on success, -1 if the dictionary could not be loaded.
+ */
+static inline int codec_init(CodecContext *ctx) {
+    memset(ctx, 0, sizeof(*ctx));
+#ifdef HAVE_ZSTD
+    ctx->cctx = ZSTD_createCCtx();
+    ctx->dctx = ZSTD_createDCtx();
+    if (!ctx->cctx || !ctx->dctx) return -1;
+
+    const char *path = getenv(ENV_ZSTD_DICTIONARY);
+    if (!path || !*path) return 0;
+
+    FILE *file = fopen(path, "rb");
+    if (!file) return -1;
+    void *dictionary = malloc(CODEC_MAX_DICTIONARY);
+    size_t size = dictionary ? fread(dictionary, 1, CODEC_MAX_DICTIONARY, file) : 0;
+    fclose(file);
+
+    if (size > 0) {
+        ctx->cdict = ZSTD_createCDict(dictionary, size, ZSTD_LEVEL);
+        ctx->ddict = ZSTD_createDDict(dictionary, size);
+    }
+    free(dictionary);
+    if (!ctx->cdict || !ctx->ddict) return -1;
+    ctx->dictionary = 1;
+#endif
+    return 0;
+}
+
+/**
+ * Releases the compression state.
+ *
+ * @param ctx Pointer to the CodecContext set up by codec_init.
+ */
+static inline void codec_free(CodecContext *ctx) {
+#ifdef HAVE_ZSTD
+    ZSTD_freeCDict(ctx->cdict);
+    ZSTD_freeDDict(ctx->ddict);
+    ZSTD_freeCCtx(ctx->cctx);
+    ZSTD_freeDCtx(ctx->dctx);
+#endif
+    memset(ctx, 0, sizeof(*ctx));
+}
+
+/**
+ * Run-length encodes a payload, PackBits style.
+ *
+ * A header byte below 128 is followed by header + 1 literal bytes, and a
+ * header of 128 or more by one byte repeated header - 125 times. The board
+ * is mostly spaces and unused alien slots are zero, so runs dominate.
+ *
+ * @return Encoded size, or 0 if it does not fit the capacity.
+ */
+static inline size_t rle_encode(const uint8_t *src, size_t size, uint8_t *dst, size_t capacity) {
+    size_t in = 0, out = 0;
+
+    while (in < size) {
+        size_t run = 1;
+        while (in + run < size && run < 130 && src[in + run] == src[in]) run++;
+
+        if (run >= 3) {
+            if (out + 2 > capacity) return 0;
+            dst[out++] = (uint8_t)(run + 125);
+            dst[out++] = src[in];
+            in += run;
+            continue;
+        }
+
+        // Literals until the next run of three or more
+        size_t start = in;
+        while (in < size && in - start < 128 &&
+               !(in + 2 < size && src[in] == src[in + 1] && src[in] == src[in + 2])) {
+            in++;
+        }
+        size_t count = in - start;
+        if (out + 1 + count > capacity) return 0;
+        dst[out++] = (uint8_t)(count - 1);
+        memcpy(dst + out, src + start, count);
+        out += count;
+    }
+    return out;
+}
+
+/**
+ * Decodes a run-length encoded payload.
+ *
+ * @return Number of bytes decoded, or -1 if the input is malformed or
+ *         decodes to more than size bytes.
+ */
+static inline long rle_decode(const uint8_t *src, size_t length, uint8_t *dst, size_t size) {
+    size_t in = 0, out = 0;
+
+    while (in < length) {
+        uint8_t header = src[in++];
+        if (header < 128) {
+            size_t count = (size_t)header + 1;
+            if (in + count > length || out + count > size) return -1;
+            memcpy(dst + out, src + in, count);
+            in += count;
+            out += count;
+        } else {
+            size_t count = (size_t)header - 125;
+            if (in >= length || out + count > size) return -1;
+            memset(dst + out, src[in++], count);
+            out += count;
+        }
+    }
+    return (long)out;
+}
+
+/**
+ * Encodes a payload with a codec.
+ *
+ * @param ctx Pointer to the CodecContext set up by codec_init.
+ * @param codec The codec, which must be available.
+ * @param src The payload.
+ * @param size Size of the payload.
+ * @param dst Destination buffer, codec_bound(size) bytes are always enough.
+ * @param capacity Size of the destination buffer.
+ * @return Encoded size, or 0 on failure.
+ */
+static inline size_t codec_encode(CodecContext *ctx, int codec, const void *src, size_t size,
+                                  void *dst, size_t capacity) {
+    if (codec == CODEC_RLE) {
+        return rle_encode((const uint8_t *)src, size, (uint8_t *)dst, capacity);
+    }
+#ifdef HAVE_ZSTD
+    if (codec == CODEC_ZSTD) {
+        size_t length = ctx->cdict ? ZSTD_compress_usingCDict(ctx->cctx, dst, capacity, src, size, ctx->cdict)
+                                   : ZSTD_compressCCtx(ctx->cctx, dst, capacity, src, size, ZSTD_LEVEL);
+        return ZSTD_isError(length) ? 0 : length;
+    }
+#endif
+    (void)ctx;
+    return 0;
+}
+
+/**
+ * Decodes a frame encoded with a codec.
+ *
+ * @param ctx Pointer to the CodecContext set up by codec_init.
+ * @param codec The codec the frame was encoded with.
+ * @param src The encoded frame.
+ * @param length Size of the encoded frame.
+ * @param dst Destination for the payload.
+ * @param capacity Size of the destination.
+ * @return Size of the payload, or -1 if the frame is malformed or too large.
+ */
+static inline long codec_decode(CodecContext *ctx, int codec, const void *src, size_t length,
+                                void *dst, size_t capacity) {
+    if (codec == CODEC_RLE) {
+        return rle_decode((const uint8_t *)src, length, (uint8_t *)dst, capacity);
+    }
+#ifdef HAVE_ZSTD
+    if (codec == CODEC_ZSTD) {
+        size_t decoded = ctx->ddict ? ZSTD_decompress_usingDDict(ctx->dctx, dst, capacity, src, length, ctx->ddict)
+                                    : ZSTD_decompressDCtx(ctx->dctx, dst, capacity, src, length);
+        return ZSTD_isError(decoded) ? -1 : (long)decoded;
+    }
+#endif
+    (void)ctx;
+    return -1;
+}
+
+#endif
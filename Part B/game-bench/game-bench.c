@@ -0,0 +1,112 @@
+#include <pthread.h>  // for pthread_create, pthread_join, pthread_barrier_wait
+#include <stdint.h>   // for uint8_t, uint64_t
+#include <stdio.h>    // for printf, perror
+#include <stdlib.h>   // for atoi, atof, malloc, free
+#include <string.h>   // for strcmp
+#include <time.h>     // for clock_gettime
+#include <unistd.h>   // for sysconf
+#include "../rules-batch.h"
+
+// Steps a batch of boards in lockstep with random bots and reports the
+// aggregate simulation speed.
+//
+//   game-bench [--boards N] [--players P] [--steps S] [--threads T] [--dt SECONDS]
+
+typedef struct {
+    RulesBatch *batch;
+    uint8_t *actions;
+    pthread_barrier_t *barrier;
+    int first, last;  // Boards stepped by this thread
+    int steps;
+    double dt;
+    unsigned int seed;
+} Worker;
+
+/**
+ * Thread function stepping one range of boards.
+ *
+ * Picks random actions for the range, steps it, and waits at the barrier
+ * for the other threads, so every board is on the same step, as when a
+ * model picks the next actions from all the observations at once.
+ *
+ * @param arg Pointer to the Worker of the thread.
+ * @return NULL upon completion.
+ */
+void *bench_thread(void *arg) {
+    Worker *worker = (Worker *)arg;
+    RulesBatch *batch = worker->batch;
+
+    for (int step = 0; step < worker->steps; step++) {
+        for (int board = worker->first; board < worker->last; board++) {
+            for (int p = 0; p < MAX_PLAYERS; p++) {
+                worker->actions[(size_t)board * MAX_PLAYERS + p] =
+                    p < batch->players ? rand_r(&worker->seed) % BATCH_ACTIONS : BATCH_IDLE;
+            }
+        }
+        rules_batch_step(batch, worker->actions, worker->dt, worker->first, worker->last);
+        pthread_barrier_wait(worker->barrier);
+    }
+    return NULL;
+}
+
+/**
+ * Main function for the simulation benchmark.
+ *
+ * @return EXIT_SUCCESS on successful execution.
+ */
+int main(int argc, char *argv[]) {
+    int boards = 4096, players = 4, steps = 1000, threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    double dt = 1;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--boards") == 0 && i + 1 < argc) boards = atoi(argv[++i]);
+        if (strcmp(argv[i], "--players") == 0 && i + 1 < argc) players = atoi(argv[++i]);
+        if (strcmp(argv[i], "--steps") == 0 && i + 1 < argc) steps = atoi(argv[++i]);
+        if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) threads = atoi(argv[++i]);
+        if (strcmp(argv[i], "--dt") == 0 && i + 1 < argc) dt = atof(argv[++i]);
+    }
+    if (threads < 1) threads = 1;
+    if (threads > boards) threads = boards;
+
+    RulesBatch batch;
+    if (rules_batch_init(&batch, boards, players, 42) != 0) {
+        fprintf(stderr, "Invalid batch of %d boards with %d players, or out of memory\n", boards, players);
+        return EXIT_FAILURE;
+    }
+    uint8_t *actions = malloc((size_t)boards * MAX_PLAYERS);
+    Worker *workers = malloc(threads * sizeof(Worker));
+    pthread_t *thread_ids = malloc(threads * sizeof(pthread_t));
+    pthread_barrier_t barrier;
+    if (!actions || !workers || !thread_ids || pthread_barrier_init(&barrier, NULL, threads) != 0) {
+        perror("Failed to allocate the benchmark");
+        return EXIT_FAILURE;
+    }
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int t = 0; t < threads; t++) {
+        workers[t] = (Worker){&batch, actions, &barrier, (int)((long)boards * t / threads),
+                              (int)((long)boards * (t + 1) / threads), steps, dt, (unsigned int)t + 1};
+        if (pthread_create(&thread_ids[t], NULL, bench_thread, &workers[t]) != 0) {
+            perror("Failed to create threads");
+            return EXIT_FAILURE;
+        }
+    }
+    for (int t = 0; t < threads; t++) pthread_join(thread_ids[t], NULL);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    double board_steps = (double)boards * steps;
+    uint64_t games = 0;
+    for (int board = 0; board < boards; board++) games += batch.episodes[board] + batch.done[board];
+
+    printf("%d boards x %d steps, %d players, %d threads: %.3f s\n", boards, steps, players, threads, seconds);
+    printf("%.0f board steps/s (%.0f per thread), %llu games finished\n", board_steps / seconds,
+           board_steps / seconds / threads, (unsigned long long)games);
+
+    pthread_barrier_destroy(&barrier);
+    free(thread_ids);
+    free(workers);
+    free(actions);
+    rules_batch_free(&batch);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,491 @@
+#ifndef GAME_RULES_H
+#define GAME_RULES_H
+
+// Rules of the game, without I/O or global state, so the server, replay
+// tools, benchmarks and bots can all run them in-process. Everything a game
+// needs lives in a RulesState: the GameState published to clients, the
+// slots and tokens of the astronauts, the alien occupancy grid, the clock
+// and the random generator, so copying the struct saves the whole game.
+//
+// rules_step() applies a batch of commands and advances the clock, moving
+// the aliens once per second and spawning waves when nobody scored for
+// WAVE_SECONDS. The server drives the same primitives from its own threads
+// with the wall clock instead. Times are in seconds on the caller's clock.
+// Events carry the values of Game_event.Type, so they can be published as
+// they are.
+//
+// Zaps can be resolved against the aliens as they were up to REWIND_TICKS
+// moves ago, so a player on a slow link hits what their screen showed.
+
+#include <ctype.h>    // for isalnum
+#include <stdbool.h>  // for bool
+#include <stdint.h>   // for uint32_t, uint64_t
+#include <string.h>   // for memset, strcmp
+#include <time.h>     // for time_t
+
+#define BOARD_SIZE 20
+#define MAX_PLAYERS 8
+#define MAX_ALIENS 256 //256
+#define START_ALIENS 85 //85 // 1/3 of the board
+#define TOKEN_SIZE 7            // Validation token with its terminator
+#define STUN_SECONDS 10         // Time a stunned astronaut can neither move nor shoot
+#define SHOT_COOLDOWN_SECONDS 3 // Time between two zaps of an astronaut
+#define WAVE_SECONDS 10         // Time without a kill before a new wave of aliens
+#define RULES_MAX_EVENTS 64     // Events gathered by one call, the rest are counted as dropped
+#define REWIND_TICKS 2          // Alien moves a zap can reach back over
+
+// Structs for astronaut and alien
+typedef struct {
+    char id;
+    int x, y;
+    int score;
+    time_t stunned_time;
+    time_t last_shot_time;
+    unsigned int last_seq; // Last pipelined command sequence applied
+} Astronaut;
+
+typedef struct {
+    int x, y;
+} Alien;
+
+// Shared game state
+typedef struct {
+    Astronaut astronauts[MAX_PLAYERS];
+    Alien aliens[MAX_ALIENS];
+    char board[BOARD_SIZE][BOARD_SIZE];
+    int astronaut_count;
+    int alien_count;
+} GameState;
+
+// Constants for X and Y limits for regions
+static const int Y_MAX[] = {0, 1, 18, 19, 17, 17, 17, 17};
+static const int Y_MIN[] = {0, 1, 18, 19, 2, 2, 2, 2};
+static const int X_MAX[] = {17, 17, 17, 17, 0, 1, 18, 19};
+static const int X_MIN[] = {2, 2, 2, 2, 0, 1, 18, 19};
+
+// Where the aliens were before one move, in the same order as GameState
+typedef struct {
+    uint64_t tick;   // Tick the positions belong to
+    int alien_count;
+    Alien aliens[MAX_ALIENS];
+} AlienHistory;
+
+// Everything the rules read and write
+typedef struct {
+    GameState game;
+    int ids_in_use[MAX_PLAYERS];                  // 1 while the slot's astronaut plays
+    char tokens[MAX_PLAYERS][TOKEN_SIZE];         // Validation token of each slot
+    bool alien_placement[BOARD_SIZE][BOARD_SIZE]; // Cells holding an alien
+    double now;                                   // Current time
+    double next_tick;                             // When rules_step moves the aliens next
+    time_t last_alien_shot;                       // Last kill, or the last wave
+    uint64_t tick;                                // Alien movement steps so far
+    uint32_t random;                              // xorshift32 state, never 0
+    AlienHistory history[REWIND_TICKS];           // Last positions, indexed by tick % REWIND_TICKS
+} RulesState;
+
+typedef enum { RULES_CONNECT, RULES_DISCONNECT, RULES_MOVE, RULES_ZAP } RulesCommandType;
+
+typedef struct {
+    RulesCommandType type;
+    char id;                // Astronaut sending the command, unused to connect
+    char direction;         // 'U', 'D', 'L' or 'R' to move
+    char token[TOKEN_SIZE];
+    unsigned int seq;       // Pipelined sequence number, 0 if none
+    uint64_t tick;          // Tick of the board the zap was aimed at, 0 for the current one
+} RulesCommand;
+
+typedef enum {
+    RULES_OK,
+    RULES_FULL,      // No free slot to connect
+    RULES_CHEATING,  // Wrong token
+    RULES_NOT_FOUND, // No astronaut with that ID
+    RULES_STUNNED,
+    RULES_COOLDOWN,  // Zapped less than SHOT_COOLDOWN_SECONDS ago
+} RulesStatus;
+
+typedef struct {
+    RulesStatus status;
+    int slot;            // Slot of the astronaut, -1 if none
+    int points;          // Aliens hit by a zap
+    bool scores_changed; // The set of players or a score changed
+} RulesResult;
+
+// Same values as Game_event.Type
+enum {
+    RULES_EVENT_ALIEN_KILLED,
+    RULES_EVENT_ASTRONAUT_STUNNED,
+    RULES_EVENT_SPAWN_WAVE,
+    RULES_EVENT_JOIN,
+    RULES_EVENT_LEAVE,
+    RULES_EVENT_SCORE_CHANGE,
+    RULES_EVENT_ZAP,
+};
+
+typedef struct {
+    int type;
+    char astronaut, target;
+    int x, y, value;
+} RulesEvent;
+
+typedef struct {
+    RulesEvent items[RULES_MAX_EVENTS];
+    int count;
+    int dropped;
+} RulesEvents;
+
+/**
+ * Draws the next number of the game's random generator.
+ */
+static inline uint32_t rules_random(RulesState *state) {
+    uint32_t r = state->random;
+    r ^= r << 13;
+    r ^= r >> 17;
+    r ^= r << 5;
+    return state->random = r;
+}
+
+/**
+ * Records an event, if the caller wants them.
+ */
+static inline void rules_event(RulesEvents *events, int type, char astronaut, char target, int x, int y, int value) {
+    if (!events) return;
+    if (events->count == RULES_MAX_EVENTS) {
+        events->dropped++;
+        return;
+    }
+    RulesEvent event = {type, astronaut, target, x, y, value};
+    events->items[events->count++] = event;
+}
+
+/**
+ * Places an alien on a random free cell away from the borders.
+ */
+static inline void rules_place_alien(RulesState *state, int index) {
+    int x, y;
+    do {
+        x = rules_random(state) % (BOARD_SIZE - 4) + 2; // Random X position (avoiding borders)
+        y = rules_random(state) % (BOARD_SIZE - 4) + 2; // Random Y position (avoiding borders)
+    } while (state->alien_placement[x][y]); // Repeat if the spot is already taken
+
+    state->alien_placement[x][y] = true;
+    state->game.aliens[index].x = x;
+    state->game.aliens[index].y = y;
+}
+
+/**
+ * Redraws the board from the aliens and astronauts, clearing shot marks.
+ *
+ * @param state Pointer to the RulesState of the game.
+ */
+static inline void rules_update_board(RulesState *state) {
+    GameState *game = &state->game;
+    memset(game->board, ' ', sizeof(game->board));
+    for (int i = 0; i < game->alien_count; i++) game->board[game->aliens[i].x][game->aliens[i].y] = '*';
+    for (int i = 0; i < MAX_PLAYERS; i++) {
+        if (state->ids_in_use[i]) game->board[game->astronauts[i].x][game->astronauts[i].y] = game->astronauts[i].id;
+    }
+}
+
+/**
+ * Starts a new game with START_ALIENS aliens and no astronauts.
+ *
+ * @param state Pointer to the RulesState to be initialized.
+ * @param seed Seed of the random generator; the same seed and commands
+ *             always play the same game.
+ * @param now Current time.
+ */
+static inline void rules_init(RulesState *state, uint32_t seed, double now) {
+    memset(state, 0, sizeof(*state));
+    state->random = seed ? seed : 1;
+    state->now = now;
+    state->next_tick = now + 1;
+    state->last_alien_shot = (time_t)now;
+    state->game.alien_count = START_ALIENS;
+    for (int i = 0; i < START_ALIENS; i++) rules_place_alien(state, i);
+    rules_update_board(state);
+}
+
+/**
+ * Removes an alien, keeping the others in order, from the game and from
+ * its recorded past positions.
+ */
+static inline void rules_remove_alien(RulesState *state, int index) {
+    GameState *game = &state->game;
+    state->alien_placement[game->aliens[index].x][game->aliens[index].y] = false;
+    for (int i = index; i < game->alien_count - 1; i++) game->aliens[i] = game->aliens[i + 1];
+    game->alien_count--;
+
+    for (int h = 0; h < REWIND_TICKS; h++) {
+        AlienHistory *past = &state->history[h];
+        if (index >= past->alien_count) continue; // Spawned after these positions
+        for (int i = index; i < past->alien_count - 1; i++) past->aliens[i] = past->aliens[i + 1];
+        past->alien_count--;
+    }
+}
+
+/**
+ * Returns the recorded positions of a past tick, or NULL if the tick is
+ * the current one, in the future or out of the rewind window.
+ */
+static inline AlienHistory *rules_history(RulesState *state, uint64_t tick) {
+    if (tick == 0 || tick >= state->tick || state->tick - tick > REWIND_TICKS) return NULL;
+    AlienHistory *past = &state->history[tick % REWIND_TICKS];
+    return past->tick == tick ? past : NULL;
+}
+
+/**
+ * Returns the index of the alien at a cell, now or in the given past.
+ */
+static inline int rules_alien_at(const RulesState *state, const AlienHistory *past, int x, int y) {
+    if (!past && !state->alien_placement[x][y]) return -1;
+    const Alien *aliens = past ? past->aliens : state->game.aliens;
+    int count = past ? past->alien_count : state->game.alien_count;
+    for (int k = 0; k < count; k++) {
+        if (aliens[k].x == x && aliens[k].y == y) return k;
+    }
+    return -1;
+}
+
+/**
+ * Moves every alien by at most one cell in each direction, within the area
+ * between coordinates 2 and 17. An alien whose new cell is taken stays put.
+ *
+ * @param state Pointer to the RulesState of the game.
+ */
+static inline void rules_move_aliens(RulesState *state) {
+    GameState *game = &state->game;
+    AlienHistory *past = &state->history[state->tick % REWIND_TICKS];
+    past->tick = state->tick;
+    past->alien_count = game->alien_count;
+    memcpy(past->aliens, game->aliens, game->alien_count * sizeof(Alien));
+
+    for (int i = 0; i < game->alien_count; i++) {
+        int new_x = game->aliens[i].x + (int)(rules_random(state) % 3) - 1;
+        int new_y = game->aliens[i].y + (int)(rules_random(state) % 3) - 1;
+        if (new_x < 2) new_x = 2;
+        if (new_x > 17) new_x = 17;
+        if (new_y < 2) new_y = 2;
+        if (new_y > 17) new_y = 17;
+
+        if (state->alien_placement[new_x][new_y]) continue; // Skip if the spot is taken
+        state->alien_placement[game->aliens[i].x][game->aliens[i].y] = false;
+        game->aliens[i].x = new_x;
+        game->aliens[i].y = new_y;
+        state->alien_placement[new_x][new_y] = true;
+    }
+    state->tick++;
+}
+
+/**
+ * Returns whether an astronaut is still stunned at the given time.
+ */
+static inline bool rules_stunned(const Astronaut *astronaut, time_t now) {
+    return astronaut->stunned_time != 0 && now - astronaut->stunned_time < STUN_SECONDS;
+}
+
+/**
+ * Returns whether nobody scored for long enough to spawn a wave.
+ */
+static inline bool rules_wave_due(const RulesState *state) {
+    return (time_t)state->now - state->last_alien_shot > WAVE_SECONDS;
+}
+
+/**
+ * Grows the swarm by 10%, up to MAX_ALIENS, and restarts the wave timer.
+ *
+ * @param state Pointer to the RulesState of the game.
+ * @param events Receives the SPAWN_WAVE event, or NULL.
+ * @return Number of aliens added.
+ */
+static inline int rules_spawn_wave(RulesState *state, RulesEvents *events) {
+    GameState *game = &state->game;
+    int grown = game->alien_count + (game->alien_count * 10 + 99) / 100; // ceil(count * 1.1)
+    int new_alien_count = grown > MAX_ALIENS ? MAX_ALIENS : grown;
+    for (int i = game->alien_count; i < new_alien_count; i++) rules_place_alien(state, i);
+
+    int spawned = new_alien_count - game->alien_count;
+    game->alien_count = new_alien_count;
+    state->last_alien_shot = (time_t)state->now;
+    rules_event(events, RULES_EVENT_SPAWN_WAVE, 0, 0, 0, 0, spawned);
+    return spawned;
+}
+
+/**
+ * Fires the zap of an astronaut along its row or column, away from its
+ * border zone, hitting every alien and stunning every astronaut on the
+ * way. Empty cells are marked with the shot until the board is redrawn.
+ *
+ * Aliens are looked up where they were at aimed_tick when it is within the
+ * rewind window, and where they are now otherwise. Astronauts are always
+ * hit where they are now.
+ */
+static inline void rules_zap(RulesState *state, int slot, uint64_t aimed_tick, RulesResult *result,
+                             RulesEvents *events) {
+    static const int step_x[MAX_PLAYERS] = {0, 0, 0, 0, 1, 1, -1, -1};
+    static const int step_y[MAX_PLAYERS] = {1, 1, -1, -1, 0, 0, 0, 0};
+    GameState *game = &state->game;
+    Astronaut *astronaut = &game->astronauts[slot];
+    time_t now = (time_t)state->now;
+    const AlienHistory *past = rules_history(state, aimed_tick);
+
+    for (int x = astronaut->x + step_x[slot], y = astronaut->y + step_y[slot];
+         x >= 0 && x < BOARD_SIZE && y >= 0 && y < BOARD_SIZE; x += step_x[slot], y += step_y[slot]) {
+        char *cell = &game->board[x][y];
+        int alien = isalnum((unsigned char)*cell) ? -1 : rules_alien_at(state, past, x, y);
+        if (alien >= 0) {
+            result->points++;
+            astronaut->score++;
+            const Alien *hit = &game->aliens[alien];
+            if (game->board[hit->x][hit->y] == '*') game->board[hit->x][hit->y] = ' ';
+            rules_event(events, RULES_EVENT_ALIEN_KILLED, astronaut->id, 0, x, y, 0);
+            rules_remove_alien(state, alien);
+            state->last_alien_shot = now;
+        } else if (isalnum((unsigned char)*cell)) {
+            for (int k = 0; k < MAX_PLAYERS; k++) {
+                if (state->ids_in_use[k] && game->astronauts[k].x == x && game->astronauts[k].y == y) {
+                    game->astronauts[k].stunned_time = now;
+                    rules_event(events, RULES_EVENT_ASTRONAUT_STUNNED, astronaut->id, game->astronauts[k].id, x, y, 0);
+                    break;
+                }
+            }
+        } else if (*cell == ' ') {
+            *cell = step_x[slot] ? '|' : '-';
+        }
+    }
+}
+
+/**
+ * Applies one command at the current time.
+ *
+ * The board is redrawn afterwards, except after a zap, which leaves its
+ * shot marked until the next rules_update_board() so it can be shown.
+ *
+ * @param state Pointer to the RulesState of the game.
+ * @param command The command.
+ * @param result Receives the outcome of the command.
+ * @param events Receives the events of the command, or NULL.
+ */
+static inline void rules_apply(RulesState *state, const RulesCommand *command, RulesResult *result,
+                               RulesEvents *events) {
+    GameState *game = &state->game;
+    time_t now = (time_t)state->now;
+    RulesResult outcome = {RULES_OK, -1, 0, false};
+    *result = outcome;
+
+    if (command->type == RULES_CONNECT) {
+        int slot = 0;
+        while (slot < MAX_PLAYERS && state->ids_in_use[slot]) slot++;
+        if (slot == MAX_PLAYERS) {
+            result->status = RULES_FULL;
+            return;
+        }
+        state->ids_in_use[slot] = 1;
+        for (int i = 0; i < TOKEN_SIZE - 1; i++) state->tokens[slot][i] = rules_random(state) % 26 + 'A';
+        state->tokens[slot][TOKEN_SIZE - 1] = '\0';
+
+        // Randomly choose coordinates for the new astronaut within its zone
+        Astronaut astronaut = {(char)('A' + slot), 0, 0, 0, 0, 0, 0};
+        astronaut.x = X_MIN[slot] + rules_random(state) % (X_MAX[slot] - X_MIN[slot] + 1);
+        astronaut.y = Y_MIN[slot] + rules_random(state) % (Y_MAX[slot] - Y_MIN[slot] + 1);
+        game->astronauts[slot] = astronaut;
+        game->astronaut_count++;
+
+        result->slot = slot;
+        result->scores_changed = true;
+        rules_event(events, RULES_EVENT_JOIN, astronaut.id, 0, astronaut.x, astronaut.y, 0);
+        rules_update_board(state);
+        return;
+    }
+
+    int slot = command->id - 'A';
+    if (slot < 0 || slot >= MAX_PLAYERS || !state->ids_in_use[slot]) {
+        result->status = RULES_NOT_FOUND;
+        return;
+    }
+    if (strcmp(command->token, state->tokens[slot]) != 0) {
+        result->status = RULES_CHEATING;
+        return;
+    }
+    Astronaut *astronaut = &game->astronauts[slot];
+    result->slot = slot;
+
+    if (command->type == RULES_DISCONNECT) {
+        rules_event(events, RULES_EVENT_LEAVE, astronaut->id, 0, astronaut->x, astronaut->y, 0);
+        memset(astronaut, 0, sizeof(*astronaut));
+        memset(state->tokens[slot], 0, TOKEN_SIZE);
+        state->ids_in_use[slot] = 0;
+        game->astronaut_count--;
+        result->scores_changed = true;
+        rules_update_board(state);
+        return;
+    }
+
+    if (rules_stunned(astronaut, now)) {
+        result->status = RULES_STUNNED;
+        return;
+    }
+
+    if (command->type == RULES_MOVE) {
+        // Handle movement within allowed boundaries
+        if (command->direction == 'U' && astronaut->x - 1 >= X_MIN[slot]) astronaut->x--;
+        else if (command->direction == 'D' && astronaut->x + 1 <= X_MAX[slot]) astronaut->x++;
+        else if (command->direction == 'L' && astronaut->y - 1 >= Y_MIN[slot]) astronaut->y--;
+        else if (command->direction == 'R' && astronaut->y + 1 <= Y_MAX[slot]) astronaut->y++;
+        if (command->seq) astronaut->last_seq = command->seq;
+        rules_update_board(state);
+        return;
+    }
+
+    if (now - astronaut->last_shot_time < SHOT_COOLDOWN_SECONDS) {
+        result->status = RULES_COOLDOWN;
+        return;
+    }
+    astronaut->last_shot_time = now;
+    if (command->seq) astronaut->last_seq = command->seq;
+    rules_update_board(state); // Hits are read off the board
+    rules_zap(state, slot, command->tick, result, events);
+    rules_event(events, RULES_EVENT_ZAP, astronaut->id, 0, astronaut->x, astronaut->y, result->points);
+    if (result->points > 0) {
+        result->scores_changed = true;
+        rules_event(events, RULES_EVENT_SCORE_CHANGE, astronaut->id, 0, astronaut->x, astronaut->y, astronaut->score);
+    }
+}
+
+/**
+ * Applies a batch of commands at the current time, then advances the clock.
+ *
+ * The aliens move once for every whole second crossed, and a wave spawns
+ * whenever nobody scored for WAVE_SECONDS. The board is up to date on
+ * return, shot marks included until the next step.
+ *
+ * @param state Pointer to the RulesState of the game.
+ * @param commands Commands to apply, in order.
+ * @param count Number of commands.
+ * @param dt Seconds to advance the clock by after the commands.
+ * @param results Receives the outcome of each command, or NULL.
+ * @param events Receives the events of the step, or NULL.
+ */
+static inline void rules_step(RulesState *state, const RulesCommand *commands, int count, double dt,
+                              RulesResult *results, RulesEvents *events) {
+    RulesResult ignored;
+    for (int i = 0; i < count; i++) rules_apply(state, &commands[i], results ? &results[i] : &ignored, events);
+
+    double end = state->now + dt;
+    bool moved = false;
+    while (state->next_tick <= end) {
+        state->now = state->next_tick;
+        state->next_tick += 1;
+        rules_move_aliens(state);
+        if (rules_wave_due(state)) rules_spawn_wave(state, events);
+        moved = true;
+    }
+    state->now = end;
+    if (rules_wave_due(state)) {
+        rules_spawn_wave(state, events);
+        moved = true;
+    }
+    if (moved) rules_update_board(state);
+}
+
+#endif
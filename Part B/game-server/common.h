@@ -6,25 +6,42 @@
 #include <curses.h>	 // for mvwprintw, newwin, wrefresh, mvprintw, WINDOW
 #include <math.h>
 #include <pthread.h>  // for pthread_create, pthread_join
+#include <stdint.h>	  // for uint64_t, uintptr_t
 #include <stdio.h>	  // for sprintf, perror
+#include <stddef.h>	  // for offsetof
 #include <stdlib.h>
 #include <string.h>	  // for strlen, strncmp, memset
-#include <string.h>
+#include <fcntl.h>	 // for open, O_RDWR, O_CREAT
+#include <sys/mman.h> // for mmap, msync
+#include <sys/stat.h> // for fstat
 #include <time.h>	 // for time, time_t
-#include <unistd.h>	 // for sleep, NULL, fork, usleep, pid_t
+#include <unistd.h>	 // for sleep, NULL, fork, usleep, pid_t, fdatasync
 #include <zmq.h>	 // for zmq_send, zmq_close, zmq_ctx_destroy, zmq_socket
+#include "../endpoints.h"
+#include "../frame-codec.h"
+#include "../game-rules.h"
 #include "../points.pb-c.h"
+#include "../shared-state.h"
+#include "../snapshot.h"
 
-#define SERVER_ADDRESS "tcp://127.0.0.1:5533"
-#define PUBLISHER_ADDRESS "tcp://127.0.0.1:5554"
+// Endpoints used when the matching ENV_* variable of endpoints.h is unset
+#define DEFAULT_SERVER_ADDRESS "tcp://127.0.0.1:5533"
+#define DEFAULT_PUBLISHER_ADDRESS "tcp://127.0.0.1:5554"
+#define DEFAULT_PULL_ADDRESS "tcp://127.0.0.1:5559"
+#define DEFAULT_PUSH_ADDRESS "tcp://127.0.0.1:5564"
+#define DEFAULT_SNAPSHOT_ADDRESS "tcp://127.0.0.1:5569" // ROUTER serving the current snapshot on request
+#define DEFAULT_REPLICATION_ADDRESS "ipc:///tmp/space-invaders-replication" // Primary to hot standby, same host
 
-#define PULL_ADDRESS "tcp://127.0.0.1:5559" 
-#define PUSH_ADDRESS "tcp://127.0.0.1:5564"
+#define MONITOR_PUBLISHER_ADDRESS "inproc://space-publisher-monitor" // Connection events of the XPUB
 
-#define BOARD_SIZE 20
-#define MAX_PLAYERS 8
-#define MAX_ALIENS 256 //256
-#define START_ALIENS 85 //85 // 1/3 of the board
+#define TILE_SIZE 5 // Side of the board tiles published on their own topics
+#define TILES_PER_SIDE (BOARD_SIZE / TILE_SIZE)
+#define TILE_KEYFRAME_INTERVAL 10 // Every Nth publish sends unchanged tiles too
+#define OVERVIEW_INTERVAL 5 // Alien movement ticks between overview publishes
+#define SCORES_KEYFRAME_INTERVAL 16 // Incremental score mode sends all scores every Nth publish
+#define SCORES_BUFFER_SIZE 256 // Packed Simple_message with every player and removal
+#define OVERVIEW_BLOCK 4   // Side of the board blocks summarized in the overview
+#define OVERVIEW_SIDE (BOARD_SIZE / OVERVIEW_BLOCK)
 
 // Message types
 #define MSG_CONNECT "Astronaut_connect"
@@ -32,48 +49,121 @@
 #define MSG_MOVE "Astronaut_movement"
 #define MSG_ZAP "Astronaut_zap"
 #define MSG_UPDATE "Outer_space_update"
+#define MSG_OVERVIEW "Outer_space_overview" // Downsampled state for dashboards
+#define MSG_LATEST "Outer_space_latest" // Single-frame update, safe with ZMQ_CONFLATE
+#define MSG_TILE "Outer_space_tile"     // Followed by ":RR:CC", one topic per board tile
 #define MSG_SERVER "Server_terminate"
+#define MSG_CLOCK "Server_clock" // Publish timestamp, lets relays measure lag
+#define MSG_EVENT "Game_event"   // Game_event protobuf messages
+#define MSG_SCORES "MSG_SCORES"  // Simple_message protobuf messages
+#define MSG_OVERLOADED "Server overloaded, retry later"
+#define MSG_SNAPSHOT "Snapshot_request" // Sent to the snapshot endpoint, answered with a snapshot
 
+// Admission control: token buckets refilled at RATE_LIMIT_RATE per second
+#define RATE_LIMIT_RATE 10.0  // tokens per second for each session and source
+#define RATE_LIMIT_BURST 20.0 // bucket capacity
+#define ZAP_TOKEN_COST 5.0    // a zap holds the game lock for 500 ms
+#define MAX_SOURCES 64        // distinct peer addresses tracked at once
+#define INBOUND_QUEUE_LIMIT 64 // requests queued on the REP socket before dropping
 
-// Structs for astronaut and alien
+#define BOT_INTERVAL_US 250000 // Delay between commands of embedded bots
+
+// Crash recovery (--checkpoint)
+#define CHECKPOINT_MAGIC 0x33504b43  // "CKP3"
+#define WAL_MAGIC 0x324c4157         // "WAL2"
+#define WAL_COMMIT_MS 5              // Commands gathered into one command log flush
+#define WAL_COMPACT_BYTES (1 << 20)  // Command log size that triggers a compaction
+
+// Hot standby
+#define MSG_REPL_CHECKPOINT "Replication_checkpoint" // Followed by a stamp and a Checkpoint
+#define MSG_REPL_COMMAND "Replication_command"       // Followed by a stamp and a WalRecord
+#define MSG_REPL_HEARTBEAT "Replication_heartbeat"   // Followed by a stamp
+#define REPLICATION_HEARTBEAT_MS 100 // Interval of the primary's heartbeats
+#define STANDBY_TIMEOUT_MS 500       // Silence after which the standby takes over, under a tick
+#define STANDBY_REPORT_SECONDS 5     // Interval of the standby's replication lag reports
+#define TAKEOVER_BIND_ATTEMPTS 10    // Binds tried, 50 ms apart, while the primary's sockets close
+
+// Game state saved by --checkpoint, in one of the two slots of the checkpoint file
 typedef struct {
-    char id;
-    int x, y;
-    int score;
-    time_t stunned_time;
-    time_t last_shot_time;
-} Astronaut;
+    uint32_t magic;
+    uint32_t checksum;   // FNV-1a of the fields after it
+    uint64_t generation; // The valid slot with the highest generation is the latest
+    uint64_t lsn;        // First command log record not reflected in the state
+    RulesState rules;
+} Checkpoint;
 
+// Command replayed on top of the latest checkpoint after a restart
 typedef struct {
-    int x, y;
-} Alien;
+    uint32_t magic;
+    uint32_t checksum;  // FNV-1a of the fields after it
+    uint64_t lsn;       // Position in the command log
+    uint64_t generation; // Checkpoint the command was applied after
+    int64_t time;       // command_time the command was processed at
+    unsigned int seq;   // current_seq the command was processed with
+    char command[64];
+} WalRecord;
 
-// Shared game state
+// Sent by the primary in front of every replication payload
 typedef struct {
-    Astronaut astronauts[MAX_PLAYERS];
-    Alien aliens[MAX_ALIENS];
-    char board[BOARD_SIZE][BOARD_SIZE];
-    int astronaut_count;
-    int alien_count;
-} GameState;
-
-// Constants for X and Y limits for regions
-int Y_MAX[] = {0, 1, 18, 19, 17, 17, 17, 17};
-int Y_MIN[] = {0, 1, 18, 19, 2, 2, 2, 2};
-int X_MAX[] = {17, 17, 17, 17, 0, 1, 18, 19};
-int X_MIN[] = {2, 2, 2, 2, 0, 1, 18, 19};
-
-// Array para verificar quais IDs estão em uso (de 'A' a 'H')
-int astronaut_ids_in_use[MAX_PLAYERS] = {0};  // 0: disponível, 1: em uso
+    uint64_t sent_us;   // CLOCK_REALTIME when sent, for lag measurements
+    uint64_t next_lsn;  // Position of the primary's next command
+} ReplicationStamp;
 
-int on = 1;  // Flag para manter o loop do cliente ativo
+#define SNAPSHOT_MAX_SIZE (SNAPSHOT_HEADER_SIZE + MAX_PLAYERS * SNAPSHOT_PLAYER_SIZE + \
+                           BOARD_SIZE * BOARD_SIZE + MAX_ALIENS * SNAPSHOT_ALIEN_SIZE)
+_Static_assert(SNAPSHOT_MAX_SIZE <= SHM_STATE_MAX, "Snapshots do not fit the shared memory segment");
 
-time_t last_alien_shot; // Última morte de alienígena
+int on = 1;  // Flag para manter o loop do cliente ativo
 
 pthread_mutex_t mutex;
 void *context, *publisher, *socket, *pusher;
-GameState *gameState;
-char **validation_tokens;
+RulesState rules;  // The game, under the game mutex; gameState points into it
+
+typedef struct {
+    double tokens;
+    double last_refill; // monotonic seconds
+} TokenBucket;
+
+typedef struct {
+    char address[64]; // peer address reported by ZeroMQ, "" if unused
+    TokenBucket bucket;
+    double last_seen;
+} SourceBucket;
+
+unsigned int current_seq = 0; // Sequence number of the command being processed
+uint32_t publish_epoch;       // Server start time, stamped on snapshots
+uint32_t publish_seq = 0;     // Sequence number of the last published state
+
+const char *record_path = NULL; // Record every published message to this file (--record)
+int bot_count = 0;              // Bot players embedded in the server process (--bots)
+int incremental_scores = 0;     // Publish score changes only (--incremental-scores)
+const char *checkpoint_path = NULL; // Checkpoint and command log path prefix (--checkpoint)
+
+time_t command_time;  // Time the current command is processed at, logged for replay
+int replaying = 0;    // Set while the command log is replayed on startup
+
+Checkpoint *checkpoints = NULL; // The two slots of the mapped checkpoint file
+int checkpoint_latest = 0;      // Slot holding the latest checkpoint
+uint64_t checkpoint_generation = 0; // Generation of the latest checkpoint, taken or restored
+int wal_fd = -1;                // Command log, appended under the game mutex
+uint64_t wal_next_lsn = 0;      // Position of the next command logged
+int wal_pending = 0;            // Commands logged since the last flush
+pthread_mutex_t wal_mutex = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t wal_cond = PTHREAD_COND_INITIALIZER;
+
+void *replicator = NULL;        // PUB feeding hot standbys (--replicate)
+pthread_mutex_t replication_mutex = PTHREAD_MUTEX_INITIALIZER; // Heartbeats are sent outside the game mutex
+int standby = 0;                // Follow a primary until it fails (--standby)
+
+int spectators = 0;             // Connections to the publisher, counted by its socket monitor
+pthread_cond_t activity_cond = PTHREAD_COND_INITIALIZER; // Signaled when someone may have joined
+
+CodecContext codecs;                     // Compression state for the compressed topics
+int codec_subscribed[CODEC_COUNT] = {0}; // Set while a subscriber wants the codec
+
+SharedState *shared_state = NULL; // Same-host snapshot segment, set with --shm
+pthread_mutex_t shared_state_mutex = PTHREAD_MUTEX_INITIALIZER; // One seqlock writer at a time
 
-bool alien_placement[BOARD_SIZE][BOARD_SIZE] = {false};
+TokenBucket session_buckets[MAX_PLAYERS]; // one per astronaut slot
+SourceBucket source_buckets[MAX_SOURCES];
 #endif
@@ -1,80 +1,335 @@
 #include "common.h"
 
 /**
- * Sends the current game state using a protobuf message over ZeroMQ.
+ * Publishes the scores of the active players as a protobuf message.
  *
- * This function connects to a ZeroMQ socket and initializes a protobuf
- * message to encapsulate the scores and IDs of all players in the game.
- * It serializes the message and sends it through the ZeroMQ publisher
- * socket. Memory allocated for the message and player data is freed
- * after sending.
+ * Nothing is sent unless a score changed or a player joined or left since
+ * the last publish, so score traffic follows scoring events rather than
+ * commands. Every message carries a version number. With incremental_scores
+ * set, only the players that changed and those that left are sent, with a
+ * full message every SCORES_KEYFRAME_INTERVAL versions; subscribers that
+ * see a version gap wait for the next full message.
+ *
+ * The message, player entries and pack buffer are allocated once and reused,
+ * so publishing does not touch the heap. Callers must hold the game mutex.
  *
  * @param gameState Pointer to the GameState structure containing the
  *                  current scores and IDs of the astronauts.
  */
 void proto_buffer_send(GameState *gameState) {
+    static SimpleMessage msg = SIMPLE_MESSAGE__INIT;
+    static Player entries[MAX_PLAYERS];
+    static Player *players[MAX_PLAYERS];
+    static char ids[MAX_PLAYERS][2];
+    static char *left[MAX_PLAYERS];
+    static int published_score[MAX_PLAYERS];
+    static int published_in_use[MAX_PLAYERS];
+    static uint8_t buffer[SCORES_BUFFER_SIZE];
+
+    if (!msg.players) {
+        for (int i = 0; i < MAX_PLAYERS; i++) {
+            player__init(&entries[i]);
+            ids[i][0] = 'A' + i;
+            entries[i].id = ids[i];
+        }
+        msg.players = players;
+        msg.left = left;
+    }
 
-    // Initialize the Score protobuf message
-    SimpleMessage msg = SIMPLE_MESSAGE__INIT;
-    msg.n_players = MAX_PLAYERS;
-    msg.players = malloc(sizeof(Player *) * MAX_PLAYERS);
+    int full = !incremental_scores || (msg.version + 1) % SCORES_KEYFRAME_INTERVAL == 0;
+    int changed = 0;
+    msg.n_players = 0;
+    msg.n_left = 0;
 
     for (int i = 0; i < MAX_PLAYERS; i++) {
-        msg.players[i] = malloc(sizeof(Player));
-        player__init(msg.players[i]);
+        int in_use = rules.ids_in_use[i];
+        int score = in_use ? gameState->astronauts[i].score : 0;
+        int player_changed = in_use != published_in_use[i] || score != published_score[i];
+        changed |= player_changed;
+        published_in_use[i] = in_use;
+        published_score[i] = score;
+
+        if (in_use && (full || player_changed)) {
+            entries[i].score = score;
+            players[msg.n_players++] = &entries[i];
+        } else if (!in_use && player_changed && !full) {
+            left[msg.n_left++] = ids[i];
+        }
+    }
+    if (!changed) return;
+
+    msg.version++;
+    msg.incremental = !full;
 
-        char *id = malloc(2); // Allocate memory for the ID
-        id[0] = gameState->astronauts[i].id;
-        id[1] = '\0';
+    size_t length = simple_message__get_packed_size(&msg);
+    if (length > sizeof(buffer)) return;
+    simple_message__pack(&msg, buffer);
 
-        msg.players[i]->id = id;
-        msg.players[i]->score = gameState->astronauts[i].score;
+    zmq_send(publisher, MSG_SCORES, strlen(MSG_SCORES), ZMQ_SNDMORE);
+    zmq_send(publisher, buffer, length, 0);
+}
+
+
+/**
+ * Publishes the board split into tiles, each under its own topic.
+ *
+ * Tile topics have the form "Outer_space_tile:RR:CC", so clients subscribe
+ * only to the tiles in their viewport and the publisher filters out the
+ * rest. Only tiles that changed since the last publish are sent, except
+ * every TILE_KEYFRAME_INTERVAL publishes when all of them are, so new
+ * subscribers fill in their viewport. Each tile carries its own sequence
+ * number, so subscribers notice lost updates and resync from the snapshot
+ * endpoint instead of waiting for the next keyframe.
+ *
+ * @param gameState Pointer to the GameState structure to be published.
+ * @return 0 on success, -1 if a tile failed to be sent.
+ */
+int publish_tiles(GameState *gameState) {
+    static char published[BOARD_SIZE][BOARD_SIZE];
+    static unsigned int tile_seq[TILES_PER_SIDE][TILES_PER_SIDE];
+    static unsigned int publish_count = 0;
+    int keyframe = publish_count++ % TILE_KEYFRAME_INTERVAL == 0;
+
+    for (int row = 0; row < TILES_PER_SIDE; row++) {
+        for (int col = 0; col < TILES_PER_SIDE; col++) {
+            uint8_t tile[TILE_RECORD_SIZE(TILE_SIZE)];
+            char *cells = tile_record_begin(tile, row, col, 0, publish_seq, publish_epoch);
+            int changed = keyframe;
+
+            for (int i = 0; i < TILE_SIZE; i++) {
+                for (int j = 0; j < TILE_SIZE; j++) {
+                    char cell = gameState->board[row * TILE_SIZE + i][col * TILE_SIZE + j];
+                    cells[i * TILE_SIZE + j] = cell;
+                    if (published[row * TILE_SIZE + i][col * TILE_SIZE + j] != cell) changed = 1;
+                    published[row * TILE_SIZE + i][col * TILE_SIZE + j] = cell;
+                }
+            }
+            if (!changed) continue;
+            snapshot_put32(tile + TILE_RECORD_SEQ, ++tile_seq[row][col]);
+
+            char topic[32];
+            int topic_len = snprintf(topic, sizeof(topic), "%s:%02d:%02d", MSG_TILE, row, col);
+            if (zmq_send(publisher, topic, topic_len, ZMQ_SNDMORE) == -1 ||
+                zmq_send(publisher, tile, sizeof(tile), 0) == -1) {
+                return -1;
+            }
+        }
+    }
+    return 0;
+}
+
+/**
+ * Updates which compressed topics have subscribers.
+ *
+ * The publisher is an XPUB socket, so every subscription change arriving
+ * from subscribers (or relays) is read from it as a message: a byte set to
+ * 1 or 0 followed by the topic. Duplicate subscriptions are filtered by
+ * ZeroMQ, so a codec's flag drops only when its last subscriber leaves.
+ */
+void track_subscriptions() {
+    char message[256];
+    size_t prefix = strlen(MSG_COMPRESSED);
+    int bytes;
+
+    while ((bytes = zmq_recv(publisher, message, sizeof(message), ZMQ_DONTWAIT)) > 0) {
+        if (bytes > (int)sizeof(message) || (size_t)bytes <= 1 + prefix ||
+            memcmp(message + 1, MSG_COMPRESSED, prefix) != 0) {
+            continue;
+        }
+        int codec = codec_lookup(message + 1 + prefix, bytes - 1 - prefix);
+        if (codec != -1 && codec_available(codec)) {
+            codec_subscribed[codec] = message[0] == 1;
+        }
     }
+}
 
-    // Serialize the message
-    int msg_len = simple_message__get_packed_size(&msg);
-    char *msg_buf = malloc(msg_len);
-    simple_message__pack(&msg, msg_buf);
+/**
+ * Publishes the state payload once for every codec that has a subscriber.
+ *
+ * @param payload The snapshot of the game state.
+ * @param size Size of the payload.
+ * @return 0 on success, -1 if a frame failed to be encoded or sent.
+ */
+int publish_compressed(const char *payload, size_t size) {
+    track_subscriptions();
+
+    for (int codec = 0; codec < CODEC_COUNT; codec++) {
+        if (!codec_subscribed[codec]) continue;
+
+        char topic[64];
+        char encoded[codec_bound(size)];
+        snprintf(topic, sizeof(topic), "%s%s", MSG_COMPRESSED, codec_names[codec]);
+        size_t length = codec_encode(&codecs, codec, payload, size, encoded, sizeof(encoded));
+        if (length == 0 ||
+            zmq_send(publisher, topic, strlen(topic), ZMQ_SNDMORE) == -1 ||
+            zmq_send(publisher, encoded, length, 0) == -1) {
+            return -1;
+        }
+    }
+    return 0;
+}
 
-    // Send the serialized data over ZeroMQ
-    // Send the serialized data with a topic
-    const char *topic = "MSG_SCORES"; // Topic for the message
-    zmq_send(publisher, topic, strlen(topic), ZMQ_SNDMORE);
-    zmq_send(publisher, msg_buf, msg_len, 0);
+/**
+ * Writes the game state in the snapshot.h format.
+ *
+ * @param gameState Pointer to the GameState structure to be written.
+ * @param snapshot Destination, at least SNAPSHOT_MAX_SIZE bytes.
+ * @param seq Sequence number stamped on the snapshot.
+ * @return Size of the snapshot in bytes.
+ */
+size_t build_snapshot(GameState *gameState, unsigned char *snapshot, uint32_t seq) {
+    time_t now = time(NULL);
+    size_t size = snapshot_begin(snapshot, BOARD_SIZE, MAX_PLAYERS, gameState->alien_count,
+                                 gameState->astronaut_count);
+    snapshot_set_sequence(snapshot, publish_epoch, seq);
+    snapshot_set_tick(snapshot, rules.tick);
 
-    // Cleanup
-    free(msg_buf);
     for (int i = 0; i < MAX_PLAYERS; i++) {
-        free(msg.players[i]->id);
-        free(msg.players[i]);
+        Astronaut *astronaut = &gameState->astronauts[i];
+        snapshot_set_player(snapshot, i, astronaut->id, rules.ids_in_use[i],
+                            rules_stunned(astronaut, now) ? SNAPSHOT_STUNNED : 0,
+                            astronaut->x, astronaut->y, astronaut->score, astronaut->last_seq);
     }
-    free(msg.players);
+    memcpy(snapshot_board_mut(snapshot), gameState->board, sizeof(gameState->board));
+    for (int i = 0; i < gameState->alien_count; i++) {
+        snapshot_set_alien(snapshot, i, gameState->aliens[i].x, gameState->aliens[i].y);
+    }
+    return size;
 }
 
+/**
+ * Publishes the full game state to all subscribers.
+ *
+ * The state is written once in the versioned snapshot.h format, stamped
+ * with the next sequence number, and sent as a two-part message: the
+ * MSG_UPDATE topic and the snapshot. The same snapshot goes out as a
+ * single MSG_LATEST frame, which subscribers using ZMQ_CONFLATE can
+ * receive without splitting a multipart sequence, compressed for the
+ * codecs subscribers asked for, and into the shared memory segment when
+ * enabled, while the board is published tile by tile for viewport
+ * subscribers. Callers must hold the game mutex, which also serializes
+ * reads of subscriptions from the publisher.
+ *
+ * @param gameState Pointer to the GameState structure to be published.
+ * @return 0 on success, -1 if any part failed to be sent.
+ */
+int publish_state(GameState *gameState) {
+    unsigned char latest[strlen(MSG_LATEST) + SNAPSHOT_MAX_SIZE];
+    unsigned char *snapshot = latest + strlen(MSG_LATEST);
+    memcpy(latest, MSG_LATEST, strlen(MSG_LATEST));
+    size_t size = build_snapshot(gameState, snapshot, ++publish_seq);
+
+    if (zmq_send(publisher, MSG_UPDATE, strlen(MSG_UPDATE), ZMQ_SNDMORE) == -1 ||
+        zmq_send(publisher, snapshot, size, 0) == -1 ||
+        zmq_send(publisher, latest, strlen(MSG_LATEST) + size, 0) == -1 ||
+        publish_compressed((const char *)snapshot, size) == -1 ||
+        publish_tiles(gameState) == -1) {
+        return -1;
+    }
+
+    if (shared_state) {
+        pthread_mutex_lock(&shared_state_mutex);
+        shared_state_write(shared_state, snapshot, size);
+        pthread_mutex_unlock(&shared_state_mutex);
+    }
+    return 0;
+}
 
 /**
- * Updates the game board in the GameState structure.
+ * Publishes a game event on the MSG_EVENT topic.
  *
- * This function clears the current game board and then populates it with
- * the positions of aliens and astronauts. Aliens are represented by '*'
- * and astronauts by their respective IDs. The board is updated based on
- * the current positions stored in the GameState.
+ * Consumers such as score keepers, analytics and replay tools follow this
+ * feed instead of diffing full states. Callers must hold the game mutex,
+ * like for every other publish.
  *
- * @param gameState Pointer to the GameState structure containing the
- *                  current positions of aliens and astronauts.
+ * @param type What happened.
+ * @param astronaut Astronaut the event is about, 0 if none.
+ * @param target Astronaut stunned by the shot, 0 if none.
+ * @param x Row where it happened.
+ * @param y Column where it happened.
+ * @param value New score for SCORE_CHANGE, aliens spawned for SPAWN_WAVE,
+ *              aliens hit for ZAP.
  */
-void update_board(GameState *gameState) {
-  memset(gameState->board, ' ', sizeof(gameState->board));
+void publish_event(GameEvent__Type type, char astronaut, char target, int x, int y, int value) {
+    char who[2] = {astronaut, '\0'}, whom[2] = {target, '\0'};
+    GameEvent event = GAME_EVENT__INIT;
+    event.type = type;
+    event.tick = rules.tick;
+    event.astronaut = who;
+    event.target = whom;
+    event.x = x;
+    event.y = y;
+    event.value = value;
+
+    uint8_t buffer[64];
+    size_t length = game_event__get_packed_size(&event);
+    if (length > sizeof(buffer)) return;
+    game_event__pack(&event, buffer);
+
+    zmq_send(publisher, MSG_EVENT, strlen(MSG_EVENT), ZMQ_SNDMORE);
+    zmq_send(publisher, buffer, length, 0);
+}
 
-  // Add remaining aliens
-  for (int i = 0; i < gameState->alien_count; i++)
-    gameState->board[gameState->aliens[i].x][gameState->aliens[i].y] = '*';
+/**
+ * Publishes the low-detail overview used by dashboards.
+ *
+ * The board is summarized as the number of aliens in each OVERVIEW_BLOCK
+ * square block, together with the score table, which is a small fraction of
+ * the full state.
+ *
+ * @param gameState Pointer to the GameState structure to be summarized.
+ * @return 0 on success, -1 if the overview failed to be sent.
+ */
+int publish_overview(GameState *gameState) {
+    int density[OVERVIEW_SIDE][OVERVIEW_SIDE] = {{0}};
+    for (int i = 0; i < gameState->alien_count; i++) {
+        density[gameState->aliens[i].x / OVERVIEW_BLOCK][gameState->aliens[i].y / OVERVIEW_BLOCK]++;
+    }
 
-  // Add astronauts
-  for (int i = 0; i < MAX_PLAYERS; i++)
-    if (astronaut_ids_in_use[i])
-      gameState->board[gameState->astronauts[i].x][gameState->astronauts[i].y] =
-          gameState->astronauts[i].id;
+    uint8_t overview[OVERVIEW_RECORD_SIZE(OVERVIEW_SIDE, MAX_PLAYERS)];
+    for (int row = 0; row < OVERVIEW_SIDE; row++) {
+        for (int col = 0; col < OVERVIEW_SIDE; col++) {
+            overview_record_set_density(overview, OVERVIEW_SIDE, row, col, density[row][col]);
+        }
+    }
+    for (int i = 0; i < MAX_PLAYERS; i++) {
+        int in_use = rules.ids_in_use[i];
+        overview_record_set_player(overview, OVERVIEW_SIDE, i, in_use ? gameState->astronauts[i].id : 0,
+                                   in_use ? gameState->astronauts[i].score : 0);
+    }
+
+    if (zmq_send(publisher, MSG_OVERVIEW, strlen(MSG_OVERVIEW), ZMQ_SNDMORE) == -1 ||
+        zmq_send(publisher, overview, sizeof(overview), 0) == -1) {
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * Publishes the current wall-clock time in microseconds.
+ *
+ * Relays forward this topic like any other, so each relay in a chain can
+ * measure how far behind the server it is running.
+ */
+void publish_clock() {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    uint64_t timestamp = (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+
+    zmq_send(publisher, MSG_CLOCK, strlen(MSG_CLOCK), ZMQ_SNDMORE);
+    zmq_send(publisher, &timestamp, sizeof(timestamp), 0);
+}
+
+/**
+ * Tells shared memory readers that the server is shutting down.
+ */
+void terminate_shared_state() {
+    if (!shared_state) return;
+    pthread_mutex_lock(&shared_state_mutex);
+    shared_state_terminate(shared_state);
+    shared_state_unmap(shared_state, 1);
+    shared_state = NULL;
+    pthread_mutex_unlock(&shared_state_mutex);
 }
 
 /**
@@ -147,7 +402,7 @@ void render_score(GameState *gameState) {
 
   int j = 0;
   for (int i = 0; i < MAX_PLAYERS; i++) {
-    if (astronaut_ids_in_use[i]) {
+    if (rules.ids_in_use[i]) {
       mvwprintw(score_win, 2 + j, 3, "%c - %d", gameState->astronauts[i].id,
                 gameState->astronauts[i].score);
       j++;
@@ -157,406 +412,621 @@ void render_score(GameState *gameState) {
 }
 
 /**
- * Initializes the game state for a new game session.
+ * Publishes the events produced by the game rules.
  *
- * This function sets up the initial state of the game by clearing the game
- * board, setting the astronaut count to zero, and initializing the aliens
- * with random positions within the board boundaries. The alien count is set
- * to the maximum allowed number of aliens.
+ * @param events Events of a command, a tick or a wave.
+ */
+void publish_events(const RulesEvents *events) {
+    for (int i = 0; i < events->count; i++) {
+        const RulesEvent *event = &events->items[i];
+        publish_event((GameEvent__Type)event->type, event->astronaut, event->target, event->x, event->y, event->value);
+    }
+}
+
+/**
+ * Parses a command of the text protocol.
+ *
+ * @param message The message received from a player.
+ * @param command Receives the command.
+ * @return 0 on success, -1 if the message is not a valid command.
+ */
+int parse_command(const char *message, RulesCommand *command) {
+    memset(command, 0, sizeof(*command));
+    if (strncmp(message, MSG_CONNECT, strlen(MSG_CONNECT)) == 0) {
+        command->type = RULES_CONNECT;
+        return 0;
+    }
+    if (strncmp(message, MSG_DISCONNECT, strlen(MSG_DISCONNECT)) == 0) {
+        command->type = RULES_DISCONNECT;
+        return sscanf(message + strlen(MSG_DISCONNECT), " %c %6s", &command->id, command->token) == 2 ? 0 : -1;
+    }
+    if (strncmp(message, MSG_MOVE, strlen(MSG_MOVE)) == 0) {
+        command->type = RULES_MOVE;
+        return sscanf(message + strlen(MSG_MOVE), " %c %c %6s", &command->id, &command->direction,
+                      command->token) == 3 ? 0 : -1;
+    }
+    if (strncmp(message, MSG_ZAP, strlen(MSG_ZAP)) == 0) {
+        command->type = RULES_ZAP;
+        unsigned long long tick = 0; // Optional tick of the snapshot the player aimed at
+        int fields = sscanf(message + strlen(MSG_ZAP), " %c %6s %llu", &command->id, command->token, &tick);
+        command->tick = tick;
+        return fields >= 2 ? 0 : -1;
+    }
+    return -1;
+}
+
+/**
+ * Processes incoming messages and updates the game state accordingly.
  *
- * @param gameState Pointer to the GameState structure to be initialized.
+ * Parses the command and applies it with the game rules at command_time.
+ * Unless replaying the command log, it then replies to the player,
+ * publishes the events and score changes the command caused, and renders
+ * the board; a successful zap is shown with its shot marked for half a
+ * second before the board is redrawn. Replay only rebuilds the state, so
+ * subscribers never see the logged commands twice.
+ *
+ * Commands must only depend on the game state, command_time and
+ * current_seq, which is what lets the command log replay them.
+ *
+ * @param socket Pointer to the ZeroMQ socket for sending responses, NULL
+ *               while replaying the command log.
+ * @param message The message received from a player.
+ * @param gameState Pointer to the GameState structure to be updated.
  */
-void init_game_state(GameState *gameState) {
-    bool alien_placement[BOARD_SIZE][BOARD_SIZE] = {false};
-    memset(gameState->board, ' ', sizeof(gameState->board));
-    gameState->astronaut_count = 0;
-    gameState->alien_count = START_ALIENS;
+void process_message(void *socket, char *message, GameState *gameState, void *publisher) {
+    RulesCommand command;
+    RulesResult result;
+    RulesEvents events;
+    char reply[64];
+
+    if (parse_command(message, &command) != 0) {
+        if (!replaying) zmq_send(socket, "Invalid message", 15, 0);
+        return;
+    }
+    command.seq = current_seq;
+    rules.now = command_time;
+    events.count = events.dropped = 0;
+    rules_apply(&rules, &command, &result, &events);
 
-    // Initialize aliens
-    for (int i = 0; i < START_ALIENS; i++) {
-        int x, y;
-        do {
-            x = rand() % (BOARD_SIZE - 4) + 2; // Random X position (avoiding borders)
-            y = rand() % (BOARD_SIZE - 4) + 2; // Random Y position (avoiding borders)
-        } while (alien_placement[x][y]); // Repeat if the spot is already taken
+    if (!replaying) publish_events(&events);
 
-        alien_placement[x][y] = true; // Mark the position as occupied
-        gameState->aliens[i].x = x;
-        gameState->aliens[i].y = y;
+    switch (result.status) {
+    case RULES_FULL:
+        snprintf(reply, sizeof(reply), "Sorry, the game is full");
+        break;
+    case RULES_CHEATING:
+        snprintf(reply, sizeof(reply), "Invalid token! You are cheating");
+        break;
+    case RULES_NOT_FOUND:
+        snprintf(reply, sizeof(reply), "Astronaut not found");
+        break;
+    case RULES_STUNNED:
+        snprintf(reply, sizeof(reply), "You are stunned! Cannot %s.", command.type == RULES_MOVE ? "move" : "shoot");
+        break;
+    case RULES_COOLDOWN:
+        snprintf(reply, sizeof(reply), "You must wait before shooting again.");
+        break;
+    case RULES_OK:
+        if (command.type == RULES_CONNECT) {
+            session_buckets[result.slot] = (TokenBucket){0}; // New session starts with a full bucket
+            snprintf(reply, sizeof(reply), "Welcome! You are player %c %s", 'A' + result.slot,
+                     rules.tokens[result.slot]);
+        } else if (command.type == RULES_DISCONNECT) {
+            snprintf(reply, sizeof(reply), "Disconnected");
+        } else if (command.type == RULES_MOVE) {
+            snprintf(reply, sizeof(reply), "Move processed");
+        } else {
+            if (!replaying) {
+                render_board(gameState); // Show the shot while it is marked
+                publish_state(gameState);
+                usleep(500000);
+            }
+            snprintf(reply, sizeof(reply), "This play: %d points | Current score: %d", result.points,
+                     gameState->astronauts[result.slot].score);
+        }
+        break;
     }
+    if (!replaying) {
+        if (result.scores_changed) proto_buffer_send(gameState);
+        zmq_send(socket, reply, strlen(reply), 0);
+    }
+    if (result.status != RULES_OK) return;
 
-    for (int i = 0; i < MAX_PLAYERS; i++) {
-        gameState->astronauts[i] = (Astronaut){0};
+    rules_update_board(&rules);
+    if (!replaying) {
+        render_score(gameState);
+        render_board(gameState);
     }
 }
+
 /**
- * Removes an alien from the GameState's alien array at the specified index.
- *
- * This function shifts all aliens in the array one position to the left
- * starting from the given index, effectively removing the alien at that
- * index. It then decrements the alien count in the GameState.
+ * Returns the current time of the monotonic clock in seconds.
  *
- * @param index The index of the alien to be removed.
- * @param gameState Pointer to the GameState structure from which the alien
- *                  is to be removed.
+ * @return Monotonic time in seconds.
  */
-void remove_alien(int index, GameState *gameState) {
-  alien_placement[gameState->aliens[index].x][gameState->aliens[index].y] = false;
-  for (int i = index; i < gameState->alien_count - 1; i++)
-    gameState->aliens[i] = gameState->aliens[i + 1];
-  gameState->alien_count--;
+double monotonic_seconds() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
 }
 
 /**
- * Updates the positions of all aliens in the GameState.
+ * Computes the FNV-1a hash of a buffer, used to validate checkpoints and
+ * command log records.
+ */
+uint32_t fnv1a(const void *data, size_t size) {
+    const unsigned char *bytes = data;
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < size; i++) hash = (hash ^ bytes[i]) * 16777619u;
+    return hash;
+}
+
+/**
+ * Tells whether a checkpoint slot holds a complete checkpoint.
+ */
+int checkpoint_valid(const Checkpoint *slot) {
+    return slot->magic == CHECKPOINT_MAGIC &&
+           slot->checksum == fnv1a(&slot->generation, sizeof(Checkpoint) - offsetof(Checkpoint, generation));
+}
+
+/**
+ * Sends a message to the hot standbys, stamped with the time and the
+ * position of the primary's next command.
  *
- * This function iterates over each alien in the GameState and adjusts
- * their positions randomly within a specified range. The movement is
- * constrained to ensure aliens remain within the defined area on the
- * board, specifically between coordinates 2 and 17.
+ * The replication socket never blocks: a standby too slow to keep up loses
+ * messages past the high-water mark and resynchronizes on the next
+ * checkpoint, so replication cannot hold up the game.
  *
- * @param gameState Pointer to the GameState structure containing the
- *                  current positions and count of aliens.
+ * @param topic One of the MSG_REPL_* topics, or MSG_SERVER at shutdown.
+ * @param payload Data following the stamp, or NULL for none.
+ * @param size Size of the payload.
  */
+void replicate(const char *topic, const void *payload, size_t size) {
+    if (!__atomic_load_n(&replicator, __ATOMIC_RELAXED)) return;
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ReplicationStamp stamp = {(uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000,
+                              __atomic_load_n(&wal_next_lsn, __ATOMIC_RELAXED)};
+
+    pthread_mutex_lock(&replication_mutex);
+    if (replicator) {
+        zmq_send(replicator, topic, strlen(topic), ZMQ_SNDMORE | ZMQ_DONTWAIT);
+        zmq_send(replicator, &stamp, sizeof(stamp), (payload ? ZMQ_SNDMORE : 0) | ZMQ_DONTWAIT);
+        if (payload) zmq_send(replicator, payload, size, ZMQ_DONTWAIT);
+    }
+    pthread_mutex_unlock(&replication_mutex);
+}
 
-void update_aliens(GameState *gameState) {
+/**
+ * Tells the hot standbys that the server is shutting down, so they exit
+ * instead of taking over, and closes the replication socket.
+ */
+void terminate_replication() {
+    replicate(MSG_SERVER, NULL, 0);
+    pthread_mutex_lock(&replication_mutex);
+    if (replicator) zmq_close(replicator);
+    __atomic_store_n(&replicator, NULL, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&replication_mutex);
+}
 
-    for (int i = 0; i < gameState->alien_count; i++) {
-        int new_x, new_y;
-        bool valid_move;
+/**
+ * Thread function sending heartbeats to the hot standbys.
+ *
+ * Runs without the game mutex, so a long zap does not look like a failure.
+ *
+ * @return NULL upon completion.
+ */
+void *heartbeat_thread(void *arg) {
+    while (on) {
+        replicate(MSG_REPL_HEARTBEAT, NULL, 0);
+        usleep(REPLICATION_HEARTBEAT_MS * 1000);
+    }
+    return NULL;
+}
+
+/**
+ * Saves the game state into the checkpoint slot not holding the latest one.
+ *
+ * Called with the game mutex held every time the aliens change outside of
+ * a command (movement and waves are random), so the commands logged after a
+ * checkpoint replay against exactly the state they were applied to. It is
+ * only a copy into the mapped file: flushing it to disk is left to the
+ * kernel and to the command log thread, so it never waits on the disk. A
+ * crash in the middle leaves the other slot intact. With --replicate the
+ * checkpoint is also sent to the hot standbys.
+ */
+void checkpoint_take() {
+    static Checkpoint unsaved; // Replicated only, without --checkpoint
+    if (!checkpoints && !replicator) return;
+    Checkpoint *slot = checkpoints ? &checkpoints[!checkpoint_latest] : &unsaved;
+
+    slot->generation = ++checkpoint_generation;
+    slot->lsn = wal_next_lsn;
+    slot->rules = rules;
+    slot->magic = CHECKPOINT_MAGIC;
+    slot->checksum = fnv1a(&slot->generation, sizeof(Checkpoint) - offsetof(Checkpoint, generation));
+    if (checkpoints) checkpoint_latest = !checkpoint_latest;
+    replicate(MSG_REPL_CHECKPOINT, slot, sizeof(*slot));
+}
 
-            // Random movement within the range of -1, 0, 1
-            int dx = (rand() % 3) - 1;
-            int dy = (rand() % 3) - 1;
+/**
+ * Appends a command to the command log before it is processed.
+ *
+ * Called with the game mutex held. The record is only written to the page
+ * cache; the commit thread flushes the commands gathered over WAL_COMMIT_MS
+ * with a single fdatasync, so the disk never holds up the game. A machine
+ * crash loses at most that window, a crash of the server process nothing.
+ * The record carries the generation of the checkpoint it follows, so it is
+ * never replayed on a state missing the alien moves in between.
+ * With --replicate the record is also sent to the hot standbys.
+ *
+ * @param message The command, as passed to process_message.
+ * @return 0 on success or without --checkpoint, -1 if the write failed.
+ */
+int wal_append(const char *message) {
+    if (wal_fd == -1 && !replicator) return 0;
+
+    WalRecord record = {WAL_MAGIC, 0, wal_next_lsn, checkpoint_generation, command_time, current_seq, {0}};
+    strncpy(record.command, message, sizeof(record.command) - 1);
+    record.checksum = fnv1a(&record.lsn, sizeof(record) - offsetof(WalRecord, lsn));
+    if (wal_fd != -1 && write(wal_fd, &record, sizeof(record)) != sizeof(record)) return -1;
+    __atomic_store_n(&wal_next_lsn, wal_next_lsn + 1, __ATOMIC_RELAXED); // Read by the heartbeat thread
+    replicate(MSG_REPL_COMMAND, &record, sizeof(record));
+    if (wal_fd == -1) return 0;
+
+    pthread_mutex_lock(&wal_mutex);
+    wal_pending++;
+    pthread_cond_signal(&wal_cond);
+    pthread_mutex_unlock(&wal_mutex);
+    return 0;
+}
 
-            // Calculate new position
-            new_x = gameState->aliens[i].x + dx;
-            new_y = gameState->aliens[i].y + dy;
+/**
+ * Drops the command log records already covered by the latest checkpoint.
+ *
+ * The records after it, at most a second's worth, are copied and flushed
+ * to a new log without the game mutex, once every WAL_COMPACT_BYTES of
+ * commands. The mutex is then held to carry over the few commands logged
+ * meanwhile, flush them and rename the new log over the old one, so the
+ * game only waits for that last short flush and the log on disk always
+ * holds every acknowledged command.
+ *
+ * @return 0 on success, -1 on failure, leaving the old log in place.
+ */
+int wal_compact() {
+    char path[256], temporary[256];
+    snprintf(path, sizeof(path), "%s.wal", checkpoint_path);
+    snprintf(temporary, sizeof(temporary), "%s.wal.tmp", checkpoint_path);
 
-            // Ensure the new position is within the restricted area (2–17)
-            if (new_x < 2) new_x = 2;
-            if (new_x > 17) new_x = 17;
-            if (new_y < 2) new_y = 2;
-            if (new_y > 17) new_y = 17;
+    struct stat st;
+    pthread_mutex_lock(&mutex);
+    uint64_t lsn = checkpoints[checkpoint_latest].lsn;
+    int sized = fstat(wal_fd, &st);
+    pthread_mutex_unlock(&mutex);
+    if (sized != 0) return -1;
+
+    // The checkpoint must be on disk before the records it covers are dropped
+    int fd = open(temporary, O_RDWR | O_CREAT | O_TRUNC | O_APPEND, 0644);
+    if (fd == -1) return -1;
+    int result = msync(checkpoints, 2 * sizeof(Checkpoint), MS_SYNC);
+    WalRecord record;
+    off_t offset = 0;
+    while (result == 0 && offset < st.st_size && pread(wal_fd, &record, sizeof(record), offset) == sizeof(record)) {
+        offset += sizeof(record);
+        if (record.lsn >= lsn && write(fd, &record, sizeof(record)) != sizeof(record)) result = -1;
+    }
+    if (result == 0 && fdatasync(fd) != 0) result = -1;
 
+    // Only the records logged during the copy remain, still in the page cache
+    pthread_mutex_lock(&mutex);
+    while (result == 0 && pread(wal_fd, &record, sizeof(record), offset) == sizeof(record)) {
+        offset += sizeof(record);
+        if (write(fd, &record, sizeof(record)) != sizeof(record)) result = -1;
+    }
+    if (result == 0 && (fdatasync(fd) != 0 || rename(temporary, path) != 0)) result = -1;
+    if (result == 0) {
+        close(wal_fd);
+        wal_fd = fd;
+    }
+    pthread_mutex_unlock(&mutex);
 
+    if (result != 0) {
+        close(fd);
+        unlink(temporary);
+    }
+    return result;
+}
 
-        if (alien_placement[new_x][new_y]) continue; // Skip if the spot is taken
-        alien_placement[gameState->aliens[i].x][gameState->aliens[i].y] = false; // Clear old position
-        gameState->aliens[i].x = new_x;
-        gameState->aliens[i].y = new_y;
-        alien_placement[new_x][new_y] = true; // Mark new position
+/**
+ * Thread function flushing the command log in groups.
+ *
+ * Waits for logged commands, gives the following ones WAL_COMMIT_MS to
+ * join, and flushes them all with one fdatasync. The checkpoints are
+ * flushed first, so the one the commands were applied after is on disk
+ * with them. Compacts the log once it outgrows WAL_COMPACT_BYTES.
+ *
+ * @return NULL upon completion.
+ */
+void *wal_commit_thread(void *arg) {
+    while (on) {
+        pthread_mutex_lock(&wal_mutex);
+        while (!wal_pending) pthread_cond_wait(&wal_cond, &wal_mutex);
+        pthread_mutex_unlock(&wal_mutex);
+
+        usleep(WAL_COMMIT_MS * 1000);
+        pthread_mutex_lock(&wal_mutex);
+        wal_pending = 0;
+        pthread_mutex_unlock(&wal_mutex);
+
+        // Only this thread replaces wal_fd, so it can be used without the game mutex
+        if (msync(checkpoints, 2 * sizeof(Checkpoint), MS_SYNC) != 0) perror("Failed to flush the checkpoint");
+        if (fdatasync(wal_fd) != 0) perror("Failed to flush the command log");
+
+        struct stat st;
+        if (fstat(wal_fd, &st) == 0 && st.st_size >= WAL_COMPACT_BYTES && wal_compact() != 0) {
+            perror("Failed to compact the command log");
+        }
     }
+    return NULL;
 }
 
+/**
+ * Loads a checkpoint into the game.
+ *
+ * Astronauts keep their slots and tokens, and the next command expected is
+ * the first one logged after the checkpoint.
+ *
+ * @param slot A valid checkpoint.
+ */
+void checkpoint_restore(const Checkpoint *slot) {
+    rules = slot->rules;
+    wal_next_lsn = slot->lsn;
+    checkpoint_generation = slot->generation;
+}
 
 /**
- * Processes incoming messages and updates the game state accordingly.
+ * Checks the magic number and checksum of a command log record.
  *
- * This function handles various types of messages received from players,
- * including connection requests, disconnection requests, movement commands,
- * and shooting actions. It updates the GameState structure based on the
- * message type, manages player positions, scores, and interactions with
- * aliens. The function also sends appropriate responses back to the client
- * through the provided ZeroMQ socket.
+ * @return 1 if the record is intact, 0 otherwise.
+ */
+int wal_record_valid(const WalRecord *record) {
+    return record->magic == WAL_MAGIC &&
+           record->checksum == fnv1a(&record->lsn, sizeof(*record) - offsetof(WalRecord, lsn));
+}
+
+/**
+ * Applies a logged command with the time and sequence number it was first
+ * processed with, without replying or publishing.
  *
- * @param socket Pointer to the ZeroMQ socket for sending responses.
- * @param message The message received from a player.
+ * @param record The command, which must be the next one expected.
  * @param gameState Pointer to the GameState structure to be updated.
  */
-void process_message(void *socket, char *message, GameState *gameState, void *publisher, char **validation_tokens) {
-  if (strncmp(message, MSG_CONNECT, strlen(MSG_CONNECT)) == 0) {
-    srand(time(NULL));
-    char id = '\0';
-    int index;
-    if (gameState->astronaut_count >= MAX_PLAYERS) {
-      zmq_send(socket, "Sorry, the game is full", 23, 0);
-      return;
+void replay_command(WalRecord *record, GameState *gameState) {
+    record->command[sizeof(record->command) - 1] = '\0';
+    command_time = record->time;
+    current_seq = record->seq;
+    replaying = 1;
+    process_message(NULL, record->command, gameState, publisher);
+    replaying = 0;
+    current_seq = 0;
+    wal_next_lsn++;
+}
+
+/**
+ * Restores the game saved by a previous run and starts saving this one.
+ *
+ * Maps CHECKPOINT_PATH.ckpt, loads its latest valid checkpoint into the
+ * game state, then replays the commands of CHECKPOINT_PATH.wal logged
+ * after it, stopping at the first torn or corrupt record or the first one
+ * applied after a checkpoint that never reached the disk. Astronauts keep
+ * their slots and tokens, so clients resume where they were. Must be called
+ * before the game threads start.
+ *
+ * @param gameState Pointer to the GameState structure to be restored.
+ * @return Number of commands replayed, or -1 if a file could not be opened.
+ */
+int checkpoint_recover(GameState *gameState) {
+    char path[256];
+    snprintf(path, sizeof(path), "%s.ckpt", checkpoint_path);
+    int fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (fd == -1 || ftruncate(fd, 2 * sizeof(Checkpoint)) != 0) {
+        if (fd != -1) close(fd);
+        return -1;
+    }
+    void *mapping = mmap(NULL, 2 * sizeof(Checkpoint), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) return -1;
+    checkpoints = mapping;
+
+    int valid[2] = {checkpoint_valid(&checkpoints[0]), checkpoint_valid(&checkpoints[1])};
+    checkpoint_latest = valid[1] && (!valid[0] || checkpoints[1].generation > checkpoints[0].generation);
+    if (valid[checkpoint_latest]) checkpoint_restore(&checkpoints[checkpoint_latest]);
+
+    snprintf(path, sizeof(path), "%s.wal", checkpoint_path);
+    wal_fd = open(path, O_RDWR | O_CREAT | O_APPEND, 0644);
+    if (wal_fd == -1) return -1;
+
+    WalRecord record;
+    off_t offset = 0;
+    int replayed = 0;
+    while (pread(wal_fd, &record, sizeof(record), offset) == sizeof(record) && wal_record_valid(&record) &&
+           record.lsn <= wal_next_lsn) {
+        if (record.lsn == wal_next_lsn && record.generation != checkpoint_generation) break; // Its checkpoint was lost
+        offset += sizeof(record);
+        if (record.lsn < wal_next_lsn) continue; // Already in the checkpoint
+        replay_command(&record, gameState);
+        replayed++;
     }
 
-    for (char player = 'A'; player <= 'H'; player++) {
-      index = player - 'A'; // Calcular o índice de 0 a 7
+    // Whatever follows the last good record was never acknowledged as durable
+    if (ftruncate(wal_fd, offset) != 0) return -1;
+    return replayed;
+}
 
-      if (astronaut_ids_in_use[index] == 0) {
-        astronaut_ids_in_use[index] = 1; // Marcar como em uso
-        id = player;
-        break;
-      }
-    }
-    validation_tokens[id - 'A'] = (char *)malloc(7 * sizeof(char));
-    // Create a random token
-    for (int i = 0; i <= 5; i++) {
-      validation_tokens[id - 'A'][i] =
-          (rand() % 26) + 'A'; // 26 letters from 'A' to 'Z'
-    }
-    validation_tokens[id - 'A'][6] = '\0';
-    // Randomly choose coordinates for the new astronaut
-    int x = X_MIN[index] + (rand() % (X_MAX[index] - X_MIN[index] + 1));
-    int y = Y_MIN[index] + (rand() % (Y_MAX[index] - Y_MIN[index] + 1));
-
-    gameState->astronauts[index] = (Astronaut){id, x, y, 0, 0, 0};
-    gameState->astronaut_count++;
-
-    // Send confirmation response
-    char response[50];
-    sprintf(response, "Welcome! You are player %c %s", id,
-            validation_tokens[index]);
-    zmq_send(socket, response, strlen(response), 0); // Send the message
-    proto_buffer_send(gameState);
-  } else if (strncmp(message, MSG_DISCONNECT, strlen(MSG_DISCONNECT)) == 0) {
-    int found = 0; // Track if the astronaut is found
-    char id;
-    char *token_message = malloc(7);
-    sscanf(message, "Astronaut_disconnect %c %s", &id, token_message);
-    token_message[6] = '\0';
-    if (!astronaut_ids_in_use[id - 'A'] ||
-        strcmp(token_message, validation_tokens[id - 'A']) != 0) {
-      zmq_send(socket, "Invalid token! You are cheating", 31, 0);
-      return;
-    }
-    free(token_message);
-    int index_to_remove = id - 'A'; // Index corresponds to 'A' to 'H'
-
-    if (index_to_remove >= 0 && index_to_remove < MAX_PLAYERS &&
-        astronaut_ids_in_use[index_to_remove] == 1) {
-      found = 1; // Mark as found
-
-      // Remove astronaut by resetting their values
-      gameState->astronauts[index_to_remove] =
-          (Astronaut){0}; // Reset astronaut's state
-      astronaut_ids_in_use[index_to_remove] = 0; // Mark ID as available
-      gameState->astronaut_count--;              // Decrease astronaut count
-      free(validation_tokens[id - 'A']);
-    }
-
-    // Send appropriate response
-    zmq_send(socket, found ? "Disconnected" : "Astronaut not found", 20, 0);
-    proto_buffer_send(gameState);
-  } else if (strncmp(message, MSG_MOVE, strlen(MSG_MOVE)) == 0) {
-    char id, direction;
-    char *token_message = malloc(7);
-    sscanf(message, "Astronaut_movement %c %c %s", &id, &direction,
-           token_message);
-    token_message[6] = '\0';
-    if (!astronaut_ids_in_use[id - 'A'] ||
-        strcmp(token_message, validation_tokens[id - 'A']) != 0 ||
-        token_message == NULL) {
-      zmq_send(socket, "Invalid token! You are cheating", 31, 0);
-      return;
-    }
-    free(token_message);
-    for (int i = 0; i < MAX_PLAYERS; i++) {
-      if (gameState->astronauts[i].id == id) {
-        time_t now = time(NULL);
+/**
+ * Keeps a copy of the primary's game current until the primary fails.
+ *
+ * Subscribes to the primary's replication stream, loads every checkpoint
+ * and replays every command after it, exactly like a restart from the
+ * command log. A missed command leaves the copy stale until the next
+ * checkpoint, at most a tick later. Every STANDBY_REPORT_SECONDS the lag
+ * behind the primary is printed, in milliseconds from the stamps and in
+ * commands from their positions.
+ *
+ * The standby stays headless while following: replayed commands are not
+ * rendered, so the lag reports stay readable, and the board is drawn once
+ * on takeover.
+ *
+ * Returns once a synchronized copy has heard nothing for
+ * STANDBY_TIMEOUT_MS, for the caller to take over the primary's endpoints.
+ * Must be called before the game threads start.
+ *
+ * @param gameState Pointer to the GameState structure to be kept current.
+ * @return 0 to take over, 1 if the primary shut down normally, -1 on error.
+ */
+int follow_primary(GameState *gameState) {
+    void *follower = zmq_socket(context, ZMQ_SUB);
+    if (!follower || zmq_setsockopt(follower, ZMQ_SUBSCRIBE, "", 0) != 0 ||
+        attach_endpoints(follower, endpoint(ENV_REPLICATION_ADDRESS, DEFAULT_REPLICATION_ADDRESS), 0) != 0) {
+        if (follower) zmq_close(follower);
+        return -1;
+    }
 
-        // Check if the astronaut is stunned
-        if (gameState->astronauts[i].stunned_time != 0 &&
-            (now - gameState->astronauts[i].stunned_time) < 10) {
-          zmq_send(socket, "You are stunned! Cannot move.", 31, 0);
-          return; // Prevent the astronaut from moving if stunned
-        }
-
-        int x = gameState->astronauts[i].x;
-        int y = gameState->astronauts[i].y;
-
-        // Handle movement within allowed boundaries
-        if (direction == 'U' && x - 1 >= X_MIN[i])
-          gameState->astronauts[i].x--;
-        else if (direction == 'D' && x + 1 <= X_MAX[i])
-          gameState->astronauts[i].x++;
-        else if (direction == 'L' && y - 1 >= Y_MIN[i])
-          gameState->astronauts[i].y--;
-        else if (direction == 'R' && y + 1 <= Y_MAX[i])
-          gameState->astronauts[i].y++;
-        break;
-      }
-    }
-    zmq_send(socket, "Move processed", 15, 0);
-  } else if (strncmp(message, MSG_ZAP, strlen(MSG_ZAP)) == 0) {
-    char id = message[strlen(MSG_ZAP) + 1];
-    int player = -1;
-    int previous_score;
-    int play_score = 0;
-    char *token_message = malloc(7);
-    sscanf(message, "Astronaut_zap %c %s", &id, token_message);
-    token_message[6] = '\0';
-    if (!astronaut_ids_in_use[id - 'A'] ||
-        strcmp(token_message, validation_tokens[id - 'A']) != 0) {
-      zmq_send(socket, "Invalid token! You are cheating", 31, 0);
-      return;
-    }
-    free(token_message);
-    for (int i = 0; i < MAX_PLAYERS; i++) {
-      if (gameState->astronauts[i].id == id) {
-        previous_score = gameState->astronauts[i].score;
+    Checkpoint checkpoint;
+    WalRecord record;
+    char topic[32];
+    int synced = 0, result = -1, lag_count = 0;
+    double lag_total = 0, lag_max = 0, next_report = monotonic_seconds() + STANDBY_REPORT_SECONDS;
+    uint64_t behind = 0;
+    zmq_pollitem_t item = {follower, 0, ZMQ_POLLIN, 0};
 
-        player = i;
-        time_t now = time(NULL);
+    while (1) {
+        int ready = zmq_poll(&item, 1, STANDBY_TIMEOUT_MS);
+        if (ready == -1) break;
+        if (ready == 0) {
+            if (!synced) continue; // Nothing to take over with yet
+            result = 0;
+            break;
+        }
 
-        // Check if the astronaut is stunned
-        if (gameState->astronauts[i].stunned_time != 0 &&
-            (now - gameState->astronauts[i].stunned_time) < 10) {
-          zmq_send(socket, "You are stunned! Cannot shoot.", 31, 0);
-          return; // Prevent the astronaut from shooting if stunned
+        ReplicationStamp stamp;
+        int topic_size = zmq_recv(follower, topic, sizeof(topic) - 1, 0);
+        if (topic_size == -1) break;
+        topic[topic_size < (int)sizeof(topic) - 1 ? topic_size : (int)sizeof(topic) - 1] = '\0';
+        int more = 0;
+        size_t more_size = sizeof(more);
+        zmq_getsockopt(follower, ZMQ_RCVMORE, &more, &more_size);
+        if (!more || zmq_recv(follower, &stamp, sizeof(stamp), 0) != sizeof(stamp)) continue;
+
+        int payload_size = -1;
+        zmq_getsockopt(follower, ZMQ_RCVMORE, &more, &more_size);
+        if (more && strcmp(topic, MSG_REPL_CHECKPOINT) == 0) {
+            payload_size = zmq_recv(follower, &checkpoint, sizeof(checkpoint), 0);
+        } else if (more) {
+            payload_size = zmq_recv(follower, &record, sizeof(record), 0);
         }
 
-        // Check if enough time has passed since the last shot
-        if (now - gameState->astronauts[i].last_shot_time < 3) {
-          zmq_send(socket, "You must wait before shooting again.", 38, 0);
-          return; // Prevent shooting if within cooldown period
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        double lag = ((double)ts.tv_sec * 1000000 + ts.tv_nsec / 1000 - (double)stamp.sent_us) / 1000;
+        lag_total += lag;
+        if (lag > lag_max) lag_max = lag;
+        lag_count++;
+
+        if (strcmp(topic, MSG_SERVER) == 0) {
+            result = 1;
+            break;
+        } else if (strcmp(topic, MSG_REPL_CHECKPOINT) == 0 && payload_size == sizeof(checkpoint) &&
+                   checkpoint_valid(&checkpoint)) {
+            checkpoint_restore(&checkpoint);
+            synced = 1;
+        } else if (strcmp(topic, MSG_REPL_COMMAND) == 0 && payload_size == sizeof(record) &&
+                   wal_record_valid(&record) && synced) {
+            if (record.lsn == wal_next_lsn && record.generation == checkpoint_generation) {
+                replay_command(&record, gameState);
+            } else if (record.lsn >= wal_next_lsn) {
+                synced = 0; // Missed a command or a checkpoint, wait for the next checkpoint
+            }
         }
+        behind = stamp.next_lsn > wal_next_lsn ? stamp.next_lsn - wal_next_lsn : 0;
+
+        if (monotonic_seconds() >= next_report) {
+            printf("Standby %s: replication lag %.2f ms average, %.2f ms max, %llu commands behind\n",
+                   synced ? "synchronized" : "waiting for a checkpoint", lag_total / lag_count, lag_max,
+                   (unsigned long long)behind);
+            fflush(stdout);
+            lag_total = lag_max = 0;
+            lag_count = 0;
+            next_report += STANDBY_REPORT_SECONDS;
+        }
+    }
 
-        int x = gameState->astronauts[i].x, y = gameState->astronauts[i].y;
+    zmq_close(follower);
+    return result;
+}
 
-        // Record the time of the shot
-        gameState->astronauts[i].last_shot_time = now;
+/**
+ * Returns whether nobody is playing or watching the game.
+ *
+ * Spectators are the connections to the publisher, so relays, high score
+ * tables and displays all keep the game running. An embedded recorder or
+ * bots always do.
+ *
+ * @param gameState Pointer to the GameState structure.
+ * @return 1 if the game can be suspended, 0 otherwise.
+ */
+int room_idle(GameState *gameState) {
+    return gameState->astronaut_count == 0 && spectators == 0 && !record_path && bot_count == 0;
+}
 
-        // Determine shot direction based on the player index
-        if (i == 0 || i == 1) { // Players 0 and 1: shoot to the right
-          for (int j = y + 1; j < BOARD_SIZE; j++) {
-            if (gameState->board[x][j] == '*') { // Alien hit
-              play_score++;
-              gameState->astronauts[i].score++; // Increase score
-              // Remove alien after hit
-              for (int k = 0; k < gameState->alien_count; k++) {
-                if (gameState->aliens[k].x == x &&
-                    gameState->aliens[k].y == j) {
-                  remove_alien(k, gameState); // Remove alien
-                  break;
-                }
-              }
-              last_alien_shot = now;
-            } else if (isalnum(gameState->board[x][j])) { // Astronaut
-              // hit
-              // Stun the astronaut if hit
-              for (int k = 0; k < gameState->astronaut_count; k++) {
-                if (gameState->astronauts[k].x == x &&
-                    gameState->astronauts[k].y == j) {
-                  gameState->astronauts[k].stunned_time =
-                      now; // Set stunned time
-                  break;
-                }
-              }
-            } else
-              gameState->board[x][j] =
-                  '-'; // Mark the shot with a line (horizontal)
-          }
-        } else if (i == 2 || i == 3) { // Players 2 and 3: shoot to the left
-          for (int j = y - 1; j >= 0; j--) {
-            if (gameState->board[x][j] == '*') { // Alien hit
-              play_score++;
-              gameState->astronauts[i].score++; // Increase score
-              // Remove alien after hit
-              for (int k = 0; k < gameState->alien_count; k++) {
-                if (gameState->aliens[k].x == x &&
-                    gameState->aliens[k].y == j) {
-                  remove_alien(k, gameState); // Remove alien
-                  break;
-                }
-              }
-              last_alien_shot = now;
-            } else if (isalnum(gameState->board[x][j])) { // Astronaut
-              // hit
-              // Stun the astronaut if hit
-              for (int k = 0; k < gameState->astronaut_count; k++) {
-                if (gameState->astronauts[k].x == x &&
-                    gameState->astronauts[k].y == j) {
-                  gameState->astronauts[k].stunned_time =
-                      now; // Set stunned time
-                  break;
-                }
-              }
-            } else
-              gameState->board[x][j] =
-                  '-'; // Mark the shot with a line (horizontal)
-          }
-        }
-
-        if (i == 4 || i == 5) { // Players 0 and 1: shoot to the right
-          for (int j = x + 1; j < BOARD_SIZE; j++) {
-            if (gameState->board[j][y] == '*') { // Alien hit
-              play_score++;
-              gameState->astronauts[i].score++; // Increase score
-              // Remove alien after hit
-              for (int k = 0; k < gameState->alien_count; k++) {
-                if (gameState->aliens[k].x == j &&
-                    gameState->aliens[k].y == y) {
-                  remove_alien(k, gameState); // Remove alien
-                  break;
-                }
-              }
-              last_alien_shot = now;
-            } else if (isalnum(gameState->board[j][y])) { // Astronaut
-              // hit
-              // Stun the astronaut if hit
-              for (int k = 0; k < gameState->astronaut_count; k++) {
-                if (gameState->astronauts[k].x == j &&
-                    gameState->astronauts[k].y == y) {
-                  gameState->astronauts[k].stunned_time =
-                      now; // Set stunned time
-                  break;
-                }
-              }
-            } else
-              gameState->board[j][y] =
-                  '|'; // Mark the shot with a line (horizontal)
-          }
-        } else if (i == 6 || i == 7) { // Players 2 and 3: shoot to the left
-          for (int j = x - 1; j >= 0; j--) {
-            if (gameState->board[j][y] == '*') { // Alien hit
-              play_score++;
-              gameState->astronauts[i].score++; // Increase score
-              // Remove alien after hit
-              for (int k = 0; k < gameState->alien_count; k++) {
-                if (gameState->aliens[k].x == j &&
-                    gameState->aliens[k].y == y) {
-                  remove_alien(k, gameState); // Remove alien
-                  break;
-                }
-              }
-              last_alien_shot = now;
-            } else if (isalnum(gameState->board[j][y])) { // Astronaut
-              // hit
-              // Stun the astronaut if hit
-              for (int k = 0; k < gameState->astronaut_count; k++) {
-                if (gameState->astronauts[k].x == j &&
-                    gameState->astronauts[k].y == y) {
-                  gameState->astronauts[k].stunned_time =
-                      now; // Set stunned time
-                  break;
-                }
-              }
-            } else
-              gameState->board[j][y] =
-                  '|'; // Mark the shot with a line (horizontal)
-          }
-        }
-
-        render_board(gameState); // Render the board after the shot is marked
-        zmq_send(publisher, MSG_UPDATE, strlen(MSG_UPDATE), ZMQ_SNDMORE);
-        zmq_send(publisher, astronaut_ids_in_use, sizeof(astronaut_ids_in_use), ZMQ_SNDMORE);
-        zmq_send(publisher, gameState, sizeof(GameState), 0);
-        usleep(500000);
-        break; // Break after processing the zap for the current
-               // astronaut
-      }
-    }
-    if (play_score > 0) {
-      proto_buffer_send(gameState);
-    }
-    char message[56];
-    sprintf(message, "This play: %d points | Current score: %d", play_score,
-            gameState->astronauts[player].score);
-    zmq_send(socket, message, strlen(message), 0);
-  } else {
-    zmq_send(socket, "Invalid message", 15, 0);
-    return;
-  }
-  update_board(gameState);
-  render_score(gameState);
-  render_board(gameState); // Render the board after the shot is marked
+/**
+ * Suspends the calling game thread while nobody is playing or watching.
+ *
+ * Called with the game mutex held, which is released while waiting. The
+ * thread is woken as soon as a command is processed or a connection to the
+ * publisher is accepted, so the game resumes within that event.
+ *
+ * @param gameState Pointer to the GameState structure.
+ * @return Seconds spent suspended.
+ */
+time_t wait_while_idle(GameState *gameState) {
+    time_t start = time(NULL);
+    while (on && room_idle(gameState)) pthread_cond_wait(&activity_cond, &mutex);
+    return time(NULL) - start;
 }
 
+/**
+ * Thread function counting the connections to the publisher.
+ *
+ * Reads the connection events of the XPUB socket from its monitor, which,
+ * unlike the subscription messages, can be received without the socket
+ * itself and so while the game is suspended.
+ *
+ * @param arg PAIR socket connected to MONITOR_PUBLISHER_ADDRESS, closed on return.
+ * @return NULL upon completion.
+ */
+void *spectator_monitor(void *arg) {
+    void *monitor = arg;
+
+    while (on) {
+        uint8_t event[6]; // Event number, then a value
+        char address[256];
+        if (zmq_recv(monitor, event, sizeof(event), 0) == -1 || zmq_recv(monitor, address, sizeof(address), 0) == -1) {
+            break;
+        }
+        uint16_t type;
+        memcpy(&type, event, sizeof(type));
+
+        pthread_mutex_lock(&mutex);
+        if (type == ZMQ_EVENT_ACCEPTED) spectators++;
+        if (type == ZMQ_EVENT_DISCONNECTED && spectators > 0) spectators--;
+        pthread_cond_broadcast(&activity_cond);
+        pthread_mutex_unlock(&mutex);
+    }
+
+    zmq_close(monitor);
+    return NULL;
+}
 
 /**
  * Thread function to update alien positions and broadcast game state.
@@ -564,8 +1034,10 @@ void process_message(void *socket, char *message, GameState *gameState, void *pu
  * This function runs in a loop, periodically updating the positions of
  * aliens in the GameState, updating the game board, and rendering the
  * board and scores. It then broadcasts the updated game state to clients
- * using a ZeroMQ publisher socket. The function locks a mutex to ensure
- * thread-safe updates to the GameState.
+ * using a ZeroMQ publisher socket, with the low-detail overview sent every
+ * OVERVIEW_INTERVAL ticks, and checkpointed with --checkpoint. The
+ * function locks a mutex to ensure thread-safe updates to the GameState.
+ * The aliens stand still while nobody is playing or watching.
  *
  * @param arg Pointer to the GameState structure to be updated.
  * @return NULL upon completion.
@@ -575,15 +1047,17 @@ void *alien_position_update(void *arg) {
 
   while (on) {
     pthread_mutex_lock(&mutex);
+    wait_while_idle(gameState);
 
-    update_aliens(gameState);
-    update_board(gameState);
+    rules_move_aliens(&rules);
+    rules_update_board(&rules);
     render_board(gameState);
     render_score(gameState);
 
-    zmq_send(publisher, MSG_UPDATE, strlen(MSG_UPDATE), ZMQ_SNDMORE);
-    zmq_send(publisher, astronaut_ids_in_use, sizeof(astronaut_ids_in_use), ZMQ_SNDMORE);
-    zmq_send(publisher, gameState, sizeof(GameState), 0);
+    publish_state(gameState);
+    publish_clock();
+    if ((rules.tick - 1) % OVERVIEW_INTERVAL == 0) publish_overview(gameState);
+    checkpoint_take();
 
     pthread_mutex_unlock(&mutex);
     sleep(1);
@@ -613,42 +1087,32 @@ void *increase_alien_count(void *arg) {
         // Lock mutex for alien count and related updates
         pthread_mutex_lock(&mutex);
 
-        if (now - last_alien_shot > 10) {
-            last_alien_shot = now;
-
-            int new_alien_count = (ceil(gameState->alien_count * 1.1) > MAX_ALIENS)
-                                      ? MAX_ALIENS
-                                      : ceil(gameState->alien_count * 1.1);
-            // Place new aliens
-            for (int i = gameState->alien_count; i < new_alien_count; i++) {
-                int x, y;
-                do {
-                    x = rand() % (BOARD_SIZE - 4) + 2; // Random X position (avoiding borders)
-                    y = rand() % (BOARD_SIZE - 4) + 2; // Random Y position (avoiding borders)
-                } while (alien_placement[x][y]); // Repeat until an unoccupied spot is found
-
-                gameState->aliens[i].x = x;
-                gameState->aliens[i].y = y;
-                alien_placement[x][y] = true; // Mark the position as occupied
-            }
+        // Time spent suspended does not count towards the next wave
+        time_t suspended = wait_while_idle(gameState);
+        if (suspended > 0) {
+            rules.last_alien_shot += suspended;
+            now = time(NULL);
+        }
 
-            // Update the alien count
-            gameState->alien_count = new_alien_count;
+        rules.now = now;
+        if (rules_wave_due(&rules)) {
+            RulesEvents events = {.count = 0};
+            rules_spawn_wave(&rules, &events);
+            publish_events(&events);
 
-            update_board(gameState);
+            rules_update_board(&rules);
             render_board(gameState);
             render_score(gameState);
+            checkpoint_take();
 
             // Send updates to the publisher
-            if (zmq_send(publisher, MSG_UPDATE, strlen(MSG_UPDATE), ZMQ_SNDMORE) == -1 ||
-                zmq_send(publisher, astronaut_ids_in_use, sizeof(astronaut_ids_in_use), ZMQ_SNDMORE) == -1 ||
-                zmq_send(publisher, gameState, sizeof(GameState), 0) == -1) {
+            if (publish_state(gameState) == -1) {
                 perror("Failed to send game state updates via publisher");
                 pthread_mutex_unlock(&mutex); // Unlock before breaking out
                 break;
             }
         } else {
-            time_t waiting = last_alien_shot + 10 - now;
+            time_t waiting = rules.last_alien_shot + WAVE_SECONDS + 1 - now;
             pthread_mutex_unlock(&mutex); // Unlock mutex while sleeping
             sleep(waiting);
             continue; // Reacquire lock on next iteration
@@ -673,19 +1137,22 @@ void *signal_handler(void *arg) {
     while (1) {
         int c = getch();
         if (c == 'q' || c == 'Q') {
-          on = 0;
+            // Under the mutex, so a game thread about to wait while idle sees on = 0
+            pthread_mutex_lock(&mutex);
+            on = 0;
+            pthread_cond_broadcast(&activity_cond);
+            pthread_mutex_unlock(&mutex);
             if (zmq_send(publisher, MSG_SERVER, strlen(MSG_SERVER), 0) == -1) {
                 perror("Failed to send server shutdown message via publisher");
             }
+            terminate_shared_state();
+            terminate_replication();
             break;
         } else {
             continue;
         }
     }
     // Cleanup resources
-    free(gameState);
-    for (int i = 0; i < 8; i++) free(validation_tokens[i]);
-    free(validation_tokens);
 
     endwin();
     zmq_close(socket);
@@ -695,15 +1162,126 @@ void *signal_handler(void *arg) {
     return NULL;
 }
 
+/**
+ * Refills a token bucket and tries to take tokens from it.
+ *
+ * A zeroed bucket is treated as full, so new sessions and sources start
+ * with a complete burst allowance.
+ *
+ * @param bucket Pointer to the TokenBucket to be charged.
+ * @param cost Number of tokens the command costs.
+ * @param now Current monotonic time in seconds.
+ * @return 1 if the tokens were taken, 0 if the bucket is exhausted.
+ */
+int bucket_take(TokenBucket *bucket, double cost, double now) {
+    bucket->tokens += (now - bucket->last_refill) * RATE_LIMIT_RATE;
+    if (bucket->tokens > RATE_LIMIT_BURST) bucket->tokens = RATE_LIMIT_BURST;
+    bucket->last_refill = now;
+
+    if (bucket->tokens < cost) return 0;
+    bucket->tokens -= cost;
+    return 1;
+}
+
+/**
+ * Finds the token bucket of a peer address, claiming a slot if needed.
+ *
+ * When every slot is taken, the least recently seen source is evicted.
+ *
+ * @param address Peer address reported by ZeroMQ.
+ * @param now Current monotonic time in seconds.
+ * @return Pointer to the TokenBucket of the source.
+ */
+TokenBucket *source_bucket(const char *address, double now) {
+    int oldest = 0;
+    for (int i = 0; i < MAX_SOURCES; i++) {
+        if (strcmp(source_buckets[i].address, address) == 0) {
+            source_buckets[i].last_seen = now;
+            return &source_buckets[i].bucket;
+        }
+        if (source_buckets[i].last_seen < source_buckets[oldest].last_seen) oldest = i;
+    }
+
+    memset(&source_buckets[oldest], 0, sizeof(SourceBucket));
+    snprintf(source_buckets[oldest].address, sizeof(source_buckets[oldest].address), "%s", address);
+    source_buckets[oldest].last_seen = now;
+    return &source_buckets[oldest].bucket;
+}
+
+/**
+ * Decides whether a command may be processed or must be rejected.
+ *
+ * Every command from a remote peer is charged against the bucket of its
+ * source address and, for moves and zaps carrying the right token, every
+ * command is charged against the bucket of that session, so nobody can
+ * drain another player's session by spoofing their astronaut ID. Local
+ * peers, such as the embedded bots, have no address and share no source
+ * bucket, only their sessions are limited. Zaps cost more because they
+ * hold the game lock while the shot is shown. Disconnections are always
+ * admitted so players can leave a busy server.
+ *
+ * @param message The command received from a client.
+ * @param address Peer address of the client, NULL for local peers.
+ * @return 1 if the command is admitted, 0 if it must be rejected.
+ */
+int admit_command(const char *message, const char *address) {
+    double now = monotonic_seconds();
+    RulesCommand command;
+    int parsed = parse_command(message, &command) == 0;
+    if (parsed && command.type == RULES_DISCONNECT) return 1;
+
+    double cost = parsed && command.type == RULES_ZAP ? ZAP_TOKEN_COST : 1.0;
+    if (address && !bucket_take(source_bucket(address, now), cost, now)) return 0;
+    if (!parsed || (command.type != RULES_MOVE && command.type != RULES_ZAP)) return 1;
+
+    int index = command.id - 'A';
+    if (index < 0 || index >= MAX_PLAYERS) return 1;
+    pthread_mutex_lock(&mutex);
+    int owner = rules.ids_in_use[index] && strcmp(command.token, rules.tokens[index]) == 0;
+    pthread_mutex_unlock(&mutex);
+    return !owner || bucket_take(&session_buckets[index], cost, now);
+}
+
+/**
+ * Extracts the optional sequence number appended by pipelined clients.
+ *
+ * Pipelined clients suffix their commands with " #<seq>" so replies can be
+ * matched out of order. The suffix is stripped from the message so the
+ * command can be processed as usual.
+ *
+ * @param message The command received from a client, modified in place.
+ * @param seq Pointer where the sequence number is stored.
+ * @return 1 if the message carried a sequence number, 0 otherwise.
+ */
+int strip_sequence(char *message, unsigned int *seq) {
+    char *suffix = strstr(message, " #");
+    if (!suffix || sscanf(suffix, " #%u", seq) != 1) return 0;
+    *suffix = '\0';
+    return 1;
+}
+
+/**
+ * Checks whether more player commands are already queued on the socket.
+ *
+ * @param socket Pointer to the ZeroMQ REP socket.
+ * @return 1 if a request is waiting to be received, 0 otherwise.
+ */
+int commands_pending(void *socket) {
+    int events = 0;
+    size_t events_len = sizeof(events);
+    if (zmq_getsockopt(socket, ZMQ_EVENTS, &events, &events_len) != 0) return 0;
+    return (events & ZMQ_POLLIN) != 0;
+}
+
 /**
  * Manages the server operations for the game.
  *
- * This function runs in a loop, receiving messages from clients,
- * processing them, and broadcasting updates to all connected clients.
- * It allocates memory for validation tokens, handles incoming messages,
- * updates the game state, and sends the updated state to clients using
- * ZeroMQ sockets. The function also manages the end of the game by
- * displaying final scores and cleaning up resources.
+ * This function runs in a loop, receiving commands from clients,
+ * admitting them through the rate limiter, applying them to the game
+ * state and broadcasting the updated state to all subscribers, or only
+ * the last state of a burst while commands are queued. Every command also
+ * wakes the game if it was suspended. The function also manages the end
+ * of the game by displaying final scores and cleaning up resources.
  *
  * @param arg Pointer to the GameState structure to be managed.
  * @return NULL upon completion.
@@ -711,33 +1289,40 @@ void *signal_handler(void *arg) {
 void *server_management(void *arg) {
     GameState *gameState = (GameState *)arg;
 
-    // Allocate memory for validation tokens
-    validation_tokens = malloc(8 * sizeof(char *));
-    if (!validation_tokens) {
-        perror("Failed to allocate memory for validation tokens");
-        return NULL;
-    }
-    for (int i = 0; i < 8; i++) {
-        validation_tokens[i] = calloc(32, sizeof(char));
-        if (!validation_tokens[i]) {
-            perror("Failed to allocate memory for a validation token");
-            for (int j = 0; j < i; j++) free(validation_tokens[j]); // Free already allocated memory
-            free(validation_tokens);
-            return NULL;
-        }
-    }
-
     // Main game loop
-    char message[32] = {0};
-    last_alien_shot = time(NULL);
+    char message[64] = {0};
 
     while (1) {
-        memset(message, 0, sizeof(message));
-        if (zmq_recv(socket, message, sizeof(message), 0) == -1) {
+        zmq_msg_t request;
+        zmq_msg_init(&request);
+        if (zmq_msg_recv(&request, socket, 0) == -1) {
+            zmq_msg_close(&request);
             endwin();
             return NULL;
         }
 
+        memset(message, 0, sizeof(message));
+        size_t length = zmq_msg_size(&request);
+        if (length > sizeof(message) - 1) length = sizeof(message) - 1;
+        memcpy(message, zmq_msg_data(&request), length);
+
+        const char *address = zmq_msg_gets(&request, "Peer-Address"); // NULL on inproc
+        int admitted = admit_command(message, address);
+        zmq_msg_close(&request);
+
+        // Echo the sequence number as a leading reply frame for pipelined clients
+        unsigned int seq = 0;
+        if (strip_sequence(message, &seq)) {
+            char seq_frame[16];
+            int seq_len = snprintf(seq_frame, sizeof(seq_frame), "%u", seq);
+            zmq_send(socket, seq_frame, seq_len, ZMQ_SNDMORE);
+        }
+
+        if (!admitted) {
+            zmq_send(socket, MSG_OVERLOADED, strlen(MSG_OVERLOADED), 0);
+            continue;
+        }
+
         if (strncmp(message, MSG_SERVER, strlen(MSG_SERVER)) == 0) {
             mvprintw(0, 0, "Server Ended!");
             mvprintw(1, 0, "Scores:");
@@ -749,12 +1334,17 @@ void *server_management(void *arg) {
             break;
         }
         pthread_mutex_lock(&mutex);
-        process_message(socket, message, gameState, publisher, validation_tokens);
+        current_seq = seq;
+        command_time = time(NULL);
+        if (wal_append(message) != 0) perror("Failed to log command");
+        process_message(socket, message, gameState, publisher);
+        pthread_cond_broadcast(&activity_cond); // Resume the game if it was suspended
+
+        // Shed spectator work first: while player commands are queued, skip the
+        // per-command broadcast and let the last command of the burst publish
+        int failed = !commands_pending(socket) && publish_state(gameState) == -1;
         pthread_mutex_unlock(&mutex);
-
-        if (zmq_send(publisher, MSG_UPDATE, strlen(MSG_UPDATE), ZMQ_SNDMORE) == -1 ||
-            zmq_send(publisher, astronaut_ids_in_use, sizeof(astronaut_ids_in_use), ZMQ_SNDMORE) == -1 ||
-            zmq_send(publisher, gameState, sizeof(GameState), 0) == -1) {
+        if (failed) {
             perror("Failed to send message via publisher");
             break;
         }
@@ -770,7 +1360,7 @@ void *server_management(void *arg) {
             mvprintw(0, 0, "Game Over!");
             mvprintw(1, 0, "Scores:");
             for (int i = 0; i < 8; i++) {
-                if (astronaut_ids_in_use[i]) {
+                if (rules.ids_in_use[i]) {
                     mvprintw(2 + i, 0, "Player %c: %d", gameState->astronauts[i].id, gameState->astronauts[i].score);
                 }
             }
@@ -781,12 +1371,11 @@ void *server_management(void *arg) {
     }
 
     // Cleanup
-    for (int i = 0; i < 8; i++) free(validation_tokens[i]);
-    free(validation_tokens);
+    terminate_shared_state();
+    terminate_replication();
     zmq_close(socket);
     zmq_close(publisher);
     zmq_close(pusher);
-    free(gameState);
     endwin();
     zmq_ctx_destroy(context);
     exit(0);
@@ -795,22 +1384,218 @@ void *server_management(void *arg) {
 }
 
 
+/**
+ * Thread function serving the current snapshot on request.
+ *
+ * Subscribers that join late or notice a gap in the sequence numbers send
+ * MSG_SNAPSHOT from a REQ socket to this ROUTER and get the current state
+ * right away, stamped with the sequence number of the last published state,
+ * instead of waiting for the next update or keyframe.
+ *
+ * @param arg Pointer to the GameState structure to be served.
+ * @return NULL upon completion.
+ */
+void *snapshot_service(void *arg) {
+    GameState *gameState = (GameState *)arg;
+
+    void *router = zmq_socket(context, ZMQ_ROUTER);
+    if (!router || attach_endpoints(router, endpoint(ENV_SNAPSHOT_ADDRESS, DEFAULT_SNAPSHOT_ADDRESS), 1) != 0) {
+        perror("Failed to set up ZMQ snapshot socket");
+        if (router) zmq_close(router);
+        return NULL;
+    }
+
+    while (on) {
+        zmq_pollitem_t item = {router, 0, ZMQ_POLLIN, 0};
+        if (zmq_poll(&item, 1, 500) <= 0) continue;  // Wake up now and then to check on
+
+        // Envelope from a REQ socket: identity, empty delimiter, request
+        char frames[3][256];
+        int sizes[3], count = 0, more = 1;
+        size_t more_size = sizeof(more);
+        while (more) {
+            int bytes = zmq_recv(router, frames[count < 3 ? count : 2], sizeof(frames[0]), 0);
+            if (bytes == -1) break;
+            if (count < 3) sizes[count] = bytes;
+            count++;
+            zmq_getsockopt(router, ZMQ_RCVMORE, &more, &more_size);
+        }
+        if (count != 3 || sizes[0] > (int)sizeof(frames[0]) || sizes[1] != 0 ||
+            sizes[2] != (int)strlen(MSG_SNAPSHOT) || strncmp(frames[2], MSG_SNAPSHOT, sizes[2]) != 0) {
+            continue;
+        }
+
+        unsigned char snapshot[SNAPSHOT_MAX_SIZE];
+        pthread_mutex_lock(&mutex);
+        size_t size = build_snapshot(gameState, snapshot, publish_seq);
+        pthread_mutex_unlock(&mutex);
+
+        zmq_send(router, frames[0], sizes[0], ZMQ_SNDMORE);
+        zmq_send(router, "", 0, ZMQ_SNDMORE);
+        zmq_send(router, snapshot, size, 0);
+    }
+
+    zmq_close(router);
+    return NULL;
+}
+
+/**
+ * Thread function recording every published message to a file.
+ *
+ * The recorder runs inside the server process and subscribes over inproc,
+ * so it shares the server's ZeroMQ context and never touches the network.
+ * Each frame is written as a microsecond timestamp, its size, a flag telling
+ * whether more frames of the same message follow, and its bytes.
+ *
+ * @param arg Unused.
+ * @return NULL upon completion.
+ */
+void *recorder_thread(void *arg) {
+    FILE *file = fopen(record_path, "ab");
+    if (!file) {
+        perror("Failed to open recording file");
+        return NULL;
+    }
+
+    void *recorder = zmq_socket(context, ZMQ_SUB);
+    if (!recorder || zmq_connect(recorder, INPROC_PUBLISHER_ADDRESS) != 0 ||
+        zmq_setsockopt(recorder, ZMQ_SUBSCRIBE, "", 0) != 0) {
+        perror("Failed to set up ZMQ recorder socket");
+        if (recorder) zmq_close(recorder);
+        fclose(file);
+        return NULL;
+    }
+
+    while (on) {
+        zmq_msg_t frame;
+        zmq_msg_init(&frame);
+        if (zmq_msg_recv(&frame, recorder, 0) == -1) {
+            zmq_msg_close(&frame);
+            break;
+        }
+
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        uint64_t timestamp = (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+        uint32_t size = zmq_msg_size(&frame);
+        uint8_t more = zmq_msg_more(&frame);
+
+        fwrite(&timestamp, sizeof(timestamp), 1, file);
+        fwrite(&size, sizeof(size), 1, file);
+        fwrite(&more, sizeof(more), 1, file);
+        fwrite(zmq_msg_data(&frame), 1, size, file);
+        zmq_msg_close(&frame);
+    }
+
+    fclose(file);
+    zmq_close(recorder);
+    return NULL;
+}
+
+/**
+ * Thread function playing as a bot inside the server process.
+ *
+ * The bot connects over inproc like a regular REQ client and sends a random
+ * movement or zap every BOT_INTERVAL_US microseconds until the server stops.
+ *
+ * @param arg Bot number, used to seed its random generator.
+ * @return NULL upon completion.
+ */
+void *bot_thread(void *arg) {
+    unsigned int seed = time(NULL) ^ (unsigned int)(uintptr_t)arg;
+    char reply[65], token[7], message[64];
+    char id;
+
+    void *bot = zmq_socket(context, ZMQ_REQ);
+    if (!bot || zmq_connect(bot, INPROC_SERVER_ADDRESS) != 0) {
+        perror("Failed to set up ZMQ bot socket");
+        if (bot) zmq_close(bot);
+        return NULL;
+    }
+
+    int bytes;
+    if (zmq_send(bot, MSG_CONNECT, strlen(MSG_CONNECT), 0) == -1 ||
+        (bytes = zmq_recv(bot, reply, sizeof(reply) - 1, 0)) == -1) {
+        zmq_close(bot);
+        return NULL;
+    }
+    reply[bytes < (int)sizeof(reply) ? bytes : (int)sizeof(reply) - 1] = '\0';
+    if (sscanf(reply, "Welcome! You are player %c %6s", &id, token) != 2) {
+        zmq_close(bot);
+        return NULL;
+    }
+
+    while (on) {
+        usleep(BOT_INTERVAL_US);
+        int action = rand_r(&seed) % 5;
+        if (action == 4) sprintf(message, "%s %c %s", MSG_ZAP, id, token);
+        else sprintf(message, "%s %c %c %s", MSG_MOVE, id, "UDLR"[action], token);
+
+        if (zmq_send(bot, message, strlen(message), 0) == -1 ||
+            zmq_recv(bot, reply, sizeof(reply), 0) == -1) {
+            break;
+        }
+    }
+
+    zmq_close(bot);
+    return NULL;
+}
+
+/**
+ * Binds a socket to its endpoints. A standby taking over retries for a
+ * while, in case the failed primary's sockets are not closed yet.
+ *
+ * @param socket ZeroMQ socket.
+ * @param list Comma-separated list of endpoints.
+ * @return 0 on success, -1 if any endpoint failed.
+ */
+int bind_endpoints(void *socket, const char *list) {
+    for (int attempt = 1; standby && attempt < TAKEOVER_BIND_ATTEMPTS; attempt++) {
+        if (attach_endpoints(socket, list, 1) == 0) return 0;
+        usleep(50000);
+    }
+    return attach_endpoints(socket, list, 1);
+}
+
 /**
  * Main function for the game server application.
  *
- * This function initializes ZeroMQ context and sockets for handling
- * client requests and publishing game state updates. It sets up the
- * game state, renders the initial board and scores, and forks a child
- * process to send periodic keep-alive messages. The parent process
- * continuously listens for player messages, processes them, and
- * broadcasts the updated game state. The game ends when all aliens
- * are removed, displaying the final scores before cleanup.
+ * This function initializes the ZeroMQ context and sockets for handling
+ * client requests and publishing game state updates, sets up or restores
+ * the game state, renders the initial board and scores, and starts the
+ * threads that process player commands, move the aliens and serve the
+ * current snapshot on request. The game ends when all aliens are removed,
+ * displaying the final scores before cleanup.
+ *
+ * --shm also exposes each snapshot in a shared memory segment for
+ * displays on the same host, and --incremental-scores only publishes the
+ * scores that changed. --checkpoint PATH resumes the game saved there by
+ * a previous run and keeps saving it. --record FILE and --bots N run a
+ * recorder and bot players inside the server process, connected through
+ * inproc endpoints on its own ZeroMQ context. --replicate feeds hot
+ * standbys started with --standby, which bind the server's endpoints and
+ * carry on with the game once the primary stops heartbeating.
  *
  * @return EXIT_SUCCESS on successful execution.
  */
 
-int main() {
-    srand(time(NULL));
+int main(int argc, char *argv[]) {
+    int use_shm = 0, replication = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--shm") == 0) use_shm = 1;
+        if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) record_path = argv[++i];
+        if (strcmp(argv[i], "--bots") == 0 && i + 1 < argc) bot_count = atoi(argv[++i]);
+        if (strcmp(argv[i], "--incremental-scores") == 0) incremental_scores = 1;
+        if (strcmp(argv[i], "--checkpoint") == 0 && i + 1 < argc) checkpoint_path = argv[++i];
+        if (strcmp(argv[i], "--replicate") == 0) replication = 1;
+        if (strcmp(argv[i], "--standby") == 0) standby = 1;
+    }
+    if (standby && checkpoint_path) {
+        fprintf(stderr, "--checkpoint cannot be combined with --standby\n");
+        return EXIT_FAILURE;
+    }
+
+    publish_epoch = time(NULL);
     pthread_mutex_init(&mutex, NULL);
     // Initialize ZMQ context
     context = zmq_ctx_new();
@@ -819,6 +1604,26 @@ int main() {
         return EXIT_FAILURE;
     }
 
+    // Start the game, or for a hot standby keep the primary's current until it fails
+    GameState *gameState = &rules.game;
+    if (standby) {
+        int followed = follow_primary(gameState);
+        if (followed != 0) {
+            if (followed == -1) perror("Failed to follow the primary");
+            zmq_ctx_destroy(context);
+            return followed == 1 ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+        rules_update_board(&rules); // Drawn below, for the first time on this standby
+    } else {
+        rules_init(&rules, (uint32_t)time(NULL), time(NULL));
+    }
+
+    if (use_shm && !(shared_state = shared_state_map(1))) {
+        perror("Failed to map shared memory state");
+        zmq_ctx_destroy(context);
+        return EXIT_FAILURE;
+    }
+
     // Initialize ZMQ REP socket
     socket = zmq_socket(context, ZMQ_REP);
     if (!socket) {
@@ -826,22 +1631,44 @@ int main() {
         zmq_ctx_destroy(context);
         return EXIT_FAILURE;
     }
-    if (zmq_bind(socket, SERVER_ADDRESS) != 0) {
+    int queue_limit = INBOUND_QUEUE_LIMIT;
+    zmq_setsockopt(socket, ZMQ_RCVHWM, &queue_limit, sizeof(queue_limit));
+    if (bind_endpoints(socket, endpoint(ENV_SERVER_ADDRESS, DEFAULT_SERVER_ADDRESS)) != 0 ||
+        zmq_bind(socket, INPROC_SERVER_ADDRESS) != 0) {
         perror("Failed to bind ZMQ REP socket");
         zmq_close(socket);
         zmq_ctx_destroy(context);
         return EXIT_FAILURE;
     }
 
-    // Initialize ZMQ PUB socket
-    publisher = zmq_socket(context, ZMQ_PUB);
-    if (!publisher) {
-        perror("Failed to create ZMQ PUB socket");
+    // Initialize ZMQ XPUB socket, which also reports subscriptions for the codec topics
+    publisher = zmq_socket(context, ZMQ_XPUB);
+    if (!publisher || codec_init(&codecs) != 0) {
+        perror("Failed to create ZMQ XPUB socket");
+        if (publisher) zmq_close(publisher);
+        zmq_close(socket);
+        zmq_ctx_destroy(context);
+        return EXIT_FAILURE;
+    }
+
+    // Count spectators from the first connection on, to suspend the game while there are none
+    void *monitor = zmq_socket(context, ZMQ_PAIR);
+    pthread_t monitor_thread_id;
+    if (!monitor ||
+        zmq_socket_monitor(publisher, MONITOR_PUBLISHER_ADDRESS, ZMQ_EVENT_ACCEPTED | ZMQ_EVENT_DISCONNECTED) != 0 ||
+        zmq_connect(monitor, MONITOR_PUBLISHER_ADDRESS) != 0 ||
+        pthread_create(&monitor_thread_id, NULL, spectator_monitor, monitor) != 0) {
+        perror("Failed to monitor the publisher");
+        if (monitor) zmq_close(monitor);
+        zmq_close(publisher);
         zmq_close(socket);
         zmq_ctx_destroy(context);
         return EXIT_FAILURE;
     }
-    if (zmq_bind(publisher, PUBLISHER_ADDRESS) != 0) {
+    pthread_detach(monitor_thread_id);
+
+    if (bind_endpoints(publisher, endpoint(ENV_PUBLISHER_ADDRESS, DEFAULT_PUBLISHER_ADDRESS)) != 0 ||
+        zmq_bind(publisher, INPROC_PUBLISHER_ADDRESS) != 0) {
         perror("Failed to bind ZMQ PUB socket");
         zmq_close(publisher);
         zmq_close(socket);
@@ -858,18 +1685,42 @@ int main() {
         return EXIT_FAILURE;
     }
 
-    // Allocate and initialize game state
-    GameState *gameState = malloc(sizeof(GameState));
-    if (!gameState) {
-        perror("Failed to allocate memory for game state");
-        zmq_close(publisher);
-        zmq_close(socket);
-        zmq_ctx_destroy(context);
-        return EXIT_FAILURE;
+    // Feed hot standbys with checkpoints, commands and heartbeats between ticks
+    if (replication) {
+        void *feed = zmq_socket(context, ZMQ_PUB);
+        int linger = STANDBY_TIMEOUT_MS;
+        pthread_t heartbeat_thread_id;
+        if (!feed || zmq_setsockopt(feed, ZMQ_LINGER, &linger, sizeof(linger)) != 0 ||
+            attach_endpoints(feed, endpoint(ENV_REPLICATION_ADDRESS, DEFAULT_REPLICATION_ADDRESS), 1) != 0) {
+            perror("Failed to bind the replication socket");
+            if (feed) zmq_close(feed);
+            zmq_close(publisher);
+            zmq_close(socket);
+            zmq_ctx_destroy(context);
+            return EXIT_FAILURE;
+        }
+        replicator = feed;
+        if (pthread_create(&heartbeat_thread_id, NULL, heartbeat_thread, NULL) == 0) {
+            pthread_detach(heartbeat_thread_id);
+        }
     }
 
-    init_game_state(gameState);
-
+    // Resume the game of a previous run, then keep saving this one
+    if (checkpoint_path) {
+        pthread_t wal_thread_id;
+        int replayed;
+        if ((replayed = checkpoint_recover(gameState)) == -1 ||
+            pthread_create(&wal_thread_id, NULL, wal_commit_thread, NULL) != 0) {
+            perror("Failed to restore the checkpoint");
+            zmq_close(publisher);
+            zmq_close(socket);
+            zmq_ctx_destroy(context);
+            return EXIT_FAILURE;
+        }
+        pthread_detach(wal_thread_id);
+        rules_update_board(&rules);
+    }
+    checkpoint_take(); // Also the first state sent to hot standbys
 
     render_board(gameState);
     render_score(gameState);
@@ -882,13 +1733,26 @@ int main() {
         pthread_create(&increase_thread_id, NULL, increase_alien_count, gameState) != 0 ||
         pthread_create(&terminate_thread_id, NULL, signal_handler, NULL) != 0) {
         perror("Failed to create threads");
-        free(gameState);
         zmq_close(publisher);
         zmq_close(socket);
         zmq_ctx_destroy(context);
         return EXIT_FAILURE;
     }
 
+    // Embedded components share the context and connect over inproc
+    pthread_t embedded_thread_id;
+    if (pthread_create(&embedded_thread_id, NULL, snapshot_service, gameState) == 0) {
+        pthread_detach(embedded_thread_id);
+    }
+    if (record_path && pthread_create(&embedded_thread_id, NULL, recorder_thread, NULL) == 0) {
+        pthread_detach(embedded_thread_id);
+    }
+    for (int i = 0; i < bot_count && i < MAX_PLAYERS; i++) {
+        if (pthread_create(&embedded_thread_id, NULL, bot_thread, (void *)(uintptr_t)i) == 0) {
+            pthread_detach(embedded_thread_id);
+        }
+    }
+
     // Join threads 
     pthread_join(server_thread_id, NULL);
     pthread_join(update_thread_id, NULL);
@@ -3,49 +3,46 @@
 
 #include <curses.h>	 // for delwin, mvwprintw, newwin, wrefresh, WINDOW, box
 #include <string.h>
-#include <time.h>  // for time_t
 #include <zmq.h>   // for zmq_recv, zmq_close, zmq_connect, zmq_ctx_destroy
+#include "../endpoints.h"
+#include "../frame-codec.h"
+#include "../shared-state.h"
+#include "../snapshot.h"
 
-#define PUBLISHER_ADDRESS "tcp://127.0.0.1:5554"
+#define DEFAULT_PUBLISHER_ADDRESS "tcp://127.0.0.1:5554"
+#define DEFAULT_SNAPSHOT_ADDRESS "tcp://127.0.0.1:5569"
+#define SNAPSHOT_TIMEOUT_MS 1000 // Wait for a requested snapshot at most this long
 
 #define BOARD_SIZE 20
 #define MAX_PLAYERS 8
 #define MAX_ALIENS 256
+#define OVERVIEW_BLOCK 4   // Side of the board blocks summarized in the overview
+#define OVERVIEW_SIDE (BOARD_SIZE / OVERVIEW_BLOCK)
 #define START_ALIENS 85 // 1/3 of the board
 
 #define MSG_UPDATE "Outer_space_update"
+#define MSG_OVERVIEW "Outer_space_overview" // Downsampled state for dashboards
+#define MSG_LATEST "Outer_space_latest" // Single-frame update, safe with ZMQ_CONFLATE
 #define MSG_SERVER "Server_terminate"
-
-// Structs for astronaut and alien
-typedef struct
-{
-    char id;
-    int x, y;
-    int score;
-    time_t stunned_time;
-    time_t last_shot_time;
-} Astronaut;
-
-typedef struct
-{
-    int x, y;
-} Alien;
-
-// Shared game state
-typedef struct
-{
-    Astronaut astronauts[MAX_PLAYERS];
-    Alien aliens[MAX_ALIENS];
-    char board[BOARD_SIZE][BOARD_SIZE];
-    int astronaut_count;
-    int alien_count;
-} GameState;
-
-// Array para verificar quais IDs estão em uso (de 'A' a 'H')
-int astronaut_ids_in_use[MAX_PLAYERS] = {0};  // 0: disponível, 1: em uso
-
-
-
-
+#define MSG_SNAPSHOT "Snapshot_request"
+
+#define SNAPSHOT_MAX_SIZE (SNAPSHOT_HEADER_SIZE + MAX_PLAYERS * SNAPSHOT_PLAYER_SIZE + \
+                           BOARD_SIZE * BOARD_SIZE + MAX_ALIENS * SNAPSHOT_ALIEN_SIZE)
+
+// Low-detail summary of the game for dashboards, decoded from overview records
+typedef struct {
+    unsigned char alien_density[OVERVIEW_SIDE][OVERVIEW_SIDE];  // Aliens in each block
+    char ids[MAX_PLAYERS];  // Astronaut ID, 0 if the slot is free
+    int scores[MAX_PLAYERS];
+} Overview;
+
+int overview_only = 0;  // Render the low-detail overview as a heatmap
+int codec = -1;  // Receive states compressed with this codec, set with --codec
+CodecContext codecs;
+int latest_only = 0;  // Only render the newest state, skipping queued frames
+SharedState *shared_state = NULL;  // Read states from shared memory, set with --shm
+uint32_t stream_epoch = 0, stream_seq = 0;  // Position of the snapshot on screen in the stream
+
+#include "../board-renderer.h"
 
 #endif
@@ -1,5 +1,148 @@
 #include "common.h"
 
+/**
+ * Checks a snapshot's sequence number against the snapshot on screen.
+ *
+ * Every state on the stream is a full snapshot, so a gap needs no resync:
+ * the snapshot that reveals it already replaces everything lost. Snapshots
+ * older than the one on screen, such as updates queued before a snapshot
+ * requested on join, are dropped. A new epoch means the server restarted.
+ *
+ * @param snapshot A checked snapshot.
+ * @return 1 if the snapshot is newer than the one on screen, 0 otherwise.
+ */
+int accept_sequence(const void *snapshot) {
+    uint32_t epoch = snapshot_epoch(snapshot), seq = snapshot_seq(snapshot);
+    if (epoch == stream_epoch && seq != 0 && (int32_t)(seq - stream_seq) <= 0) {
+        return 0;
+    }
+
+    stream_epoch = epoch;
+    stream_seq = seq;
+    return 1;
+}
+
+/**
+ * Receives a snapshot frame and keeps the message as the current one.
+ *
+ * The snapshot is read in place from the message buffer, so it is never
+ * copied; the previous message is released once a valid one replaces it.
+ *
+ * @param socket ZeroMQ subscriber socket.
+ * @param current Message holding the current snapshot.
+ * @param offset Bytes before the snapshot in the frame, such as the
+ *               MSG_LATEST topic.
+ * @param snapshot Set to the snapshot inside the current message.
+ * @return 1 if a snapshot was received, 0 if the frame was malformed, of
+ *         an unsupported version or older than the current one, -1 on error.
+ */
+int receive_snapshot(void *socket, zmq_msg_t *current, size_t offset, const unsigned char **snapshot) {
+    zmq_msg_t message;
+    zmq_msg_init(&message);
+    if (zmq_msg_recv(&message, socket, 0) == -1) {
+        zmq_msg_close(&message);
+        return -1;
+    }
+
+    const unsigned char *data = zmq_msg_data(&message);
+    size_t size = zmq_msg_size(&message);
+    if (size < offset || snapshot_check(data + offset, size - offset, BOARD_SIZE) != 0 ||
+        !accept_sequence(data + offset)) {
+        zmq_msg_close(&message);
+        return 0;
+    }
+
+    zmq_msg_close(current);
+    zmq_msg_init(current);
+    zmq_msg_move(current, &message);
+    *snapshot = (const unsigned char *)zmq_msg_data(current) + offset;
+    return 1;
+}
+
+/**
+ * Requests the current snapshot from the server's snapshot endpoint.
+ *
+ * @param requester ZeroMQ REQ socket connected to the snapshot endpoint.
+ * @param current Message holding the current snapshot.
+ * @param snapshot Set to the snapshot inside the current message.
+ * @return 1 if a snapshot was received, 0 if none arrived in time, -1 on error.
+ */
+int request_snapshot(void *requester, zmq_msg_t *current, const unsigned char **snapshot) {
+    if (zmq_send(requester, MSG_SNAPSHOT, strlen(MSG_SNAPSHOT), 0) == -1) return -1;
+
+    zmq_pollitem_t item = {requester, 0, ZMQ_POLLIN, 0};
+    int ready = zmq_poll(&item, 1, SNAPSHOT_TIMEOUT_MS);
+    if (ready <= 0) return ready;
+    return receive_snapshot(requester, current, 0, snapshot);
+}
+
+/**
+ * Receives a compressed snapshot and decodes it.
+ *
+ * Snapshots are decoded into whichever of the two buffers is not on screen,
+ * so a malformed or outdated frame leaves the current one intact.
+ *
+ * @param subscriber ZeroMQ subscriber socket, with the topic already read.
+ * @param buffers Two destinations for snapshots, SNAPSHOT_MAX_SIZE bytes each.
+ * @param snapshot Set to the decoded snapshot on success.
+ * @return 1 if a snapshot was received, 0 if the frame was malformed or
+ *         outdated, -1 on error.
+ */
+int receive_compressed(void *subscriber, unsigned char buffers[2][SNAPSHOT_MAX_SIZE], const unsigned char **snapshot) {
+    char encoded[codec_bound(SNAPSHOT_MAX_SIZE)];
+    int bytes = zmq_recv(subscriber, encoded, sizeof(encoded), 0);
+    if (bytes == -1) return -1;
+    if (bytes > (int)sizeof(encoded)) return 0;
+
+    unsigned char *buffer = *snapshot == buffers[0] ? buffers[1] : buffers[0];
+    long size = codec_decode(&codecs, codec, encoded, bytes, buffer, SNAPSHOT_MAX_SIZE);
+    if (size == -1 || snapshot_check(buffer, size, BOARD_SIZE) != 0 || !accept_sequence(buffer)) {
+        return 0;
+    }
+    *snapshot = buffer;
+    return 1;
+}
+
+/**
+ * Decodes an overview record received on the overview topic.
+ *
+ * @param record The record, OVERVIEW_RECORD_SIZE(OVERVIEW_SIDE, MAX_PLAYERS) bytes.
+ * @param overview Pointer to the Overview to fill.
+ */
+void decode_overview(const void *record, Overview *overview) {
+    for (int i = 0; i < OVERVIEW_SIDE; i++) {
+        for (int j = 0; j < OVERVIEW_SIDE; j++) {
+            overview->alien_density[i][j] = overview_record_density(record, OVERVIEW_SIDE, i, j);
+        }
+    }
+    for (int i = 0; i < MAX_PLAYERS; i++) {
+        overview->ids[i] = overview_record_player_id(record, OVERVIEW_SIDE, i);
+        overview->scores[i] = overview_record_player_score(record, OVERVIEW_SIDE, i);
+    }
+}
+
+/**
+ * Fills a board frame with a heatmap of the overview's alien density.
+ *
+ * Every cell of a block shows the same shade, from blank for an empty block
+ * to '@' for a full one, so the heatmap keeps the board's proportions.
+ *
+ * @param overview Pointer to the received Overview.
+ * @param frame Board frame to be filled.
+ */
+void render_heatmap(const Overview *overview, char frame[BOARD_SIZE][BOARD_SIZE]) {
+    const char *shades = " .:-=+*#%@";
+    int levels = strlen(shades) - 1;
+
+    for (int i = 0; i < BOARD_SIZE; i++) {
+        for (int j = 0; j < BOARD_SIZE; j++) {
+            int density = overview->alien_density[i / OVERVIEW_BLOCK][j / OVERVIEW_BLOCK];
+            int level = (density * levels + OVERVIEW_BLOCK * OVERVIEW_BLOCK - 1) / (OVERVIEW_BLOCK * OVERVIEW_BLOCK);
+            frame[i][j] = shades[level > levels ? levels : level];
+        }
+    }
+}
+
 /**
  * Displays the current game state in a terminal window using ncurses.
  *
@@ -8,6 +151,13 @@
  * column numbers, the game board, and player scores. Continuously receives
  * game state updates and refreshes the display accordingly.
  *
+ * States arrive as snapshot.h snapshots, which are drawn straight from the
+ * received message without being copied into a GameState.
+ *
+ * In latest-only mode the state is read from a separate conflating
+ * subscriber, so a slow terminal always renders the newest state instead of
+ * working through a backlog of queued frames.
+ *
  * Cleans up ncurses windows and ZeroMQ resources upon termination.
  */
 void display_game_state() {
@@ -25,20 +175,40 @@ void display_game_state() {
         return;
     }
 
-    if (zmq_connect(subscriber, PUBLISHER_ADDRESS) != 0) {
+    if (zmq_connect(subscriber, endpoint(ENV_PUBLISHER_ADDRESS, DEFAULT_PUBLISHER_ADDRESS)) != 0) {
         perror("Failed to connect ZeroMQ subscriber to publisher");
         zmq_close(subscriber);
         zmq_ctx_destroy(context);
         return;
     }
 
-    if (zmq_setsockopt(subscriber, ZMQ_SUBSCRIBE, MSG_UPDATE, strlen(MSG_UPDATE)) != 0) {
-        perror("Failed to set ZeroMQ subscription for MSG_UPDATE");
+    char state_topic[64];
+    snprintf(state_topic, sizeof(state_topic), "%s", overview_only ? MSG_OVERVIEW : MSG_UPDATE);
+    if (codec != -1) snprintf(state_topic, sizeof(state_topic), "%s%s", MSG_COMPRESSED, codec_names[codec]);
+    if (!latest_only && !shared_state && zmq_setsockopt(subscriber, ZMQ_SUBSCRIBE, state_topic, strlen(state_topic)) != 0) {
+        perror("Failed to set ZeroMQ subscription for the game state");
         zmq_close(subscriber);
         zmq_ctx_destroy(context);
         return;
     }
 
+    // Conflation keeps only the last message, so it needs a socket of its own
+    void *latest_sub = NULL;
+    if (latest_only) {
+        int conflate = 1;
+        latest_sub = zmq_socket(context, ZMQ_SUB);
+        if (!latest_sub ||
+            zmq_setsockopt(latest_sub, ZMQ_CONFLATE, &conflate, sizeof(conflate)) != 0 ||
+            zmq_connect(latest_sub, endpoint(ENV_PUBLISHER_ADDRESS, DEFAULT_PUBLISHER_ADDRESS)) != 0 ||
+            zmq_setsockopt(latest_sub, ZMQ_SUBSCRIBE, MSG_LATEST, strlen(MSG_LATEST)) != 0) {
+            perror("Failed to set up ZeroMQ subscriber for MSG_LATEST");
+            if (latest_sub) zmq_close(latest_sub);
+            zmq_close(subscriber);
+            zmq_ctx_destroy(context);
+            return;
+        }
+    }
+
     if (zmq_setsockopt(subscriber, ZMQ_SUBSCRIBE, MSG_SERVER, strlen(MSG_SERVER)) != 0) {
         perror("Failed to set ZeroMQ subscription for MSG_SERVER");
         zmq_close(subscriber);
@@ -107,55 +277,138 @@ void display_game_state() {
     box(board_win, 0, 0);
     box(score_win, 0, 0);
 
-    GameState gameState = {0};
-    char topic[256];
-    while (1) {
-        if (zmq_recv(subscriber, topic, sizeof(topic), 0) == -1) {
-            perror("Failed to receive topic from ZeroMQ subscriber");
-            break;
-        }
+    refresh();
+    wrefresh(line_win);
+    wrefresh(column_win);
 
-        if (strncmp(topic, MSG_SERVER, strlen(MSG_SERVER)) == 0) {
-            break;
-        }
+    Overview overview = {0};
+    char heatmap[BOARD_SIZE][BOARD_SIZE];
+    zmq_msg_t current;  // Message holding the snapshot on screen
+    unsigned char decoded[2][SNAPSHOT_MAX_SIZE];  // Snapshots copied from shared memory or decompressed
+    const unsigned char *snapshot = NULL;
+    FrameCache cache = {0};
+    uint32_t shared_seq = 0;
+    zmq_msg_init(&current);
+    int frame_pending = 0;
 
-        if (strncmp(topic, MSG_UPDATE, strlen(MSG_UPDATE)) != 0) {
-            continue;
+    // Late joiners fetch the current state instead of waiting for the next update
+    if (!shared_state && !overview_only) {
+        int linger = 0;
+        void *requester = zmq_socket(context, ZMQ_REQ);
+        if (requester && zmq_setsockopt(requester, ZMQ_LINGER, &linger, sizeof(linger)) == 0 &&
+            zmq_connect(requester, endpoint(ENV_SNAPSHOT_ADDRESS, DEFAULT_SNAPSHOT_ADDRESS)) == 0 &&
+            request_snapshot(requester, &current, &snapshot) == 1) {
+            frame_pending = 1;
         }
+        if (requester) zmq_close(requester);
+    }
 
-        if (zmq_recv(subscriber, astronaut_ids_in_use, sizeof(astronaut_ids_in_use), 0) == -1) {
-            perror("Failed to receive astronaut IDs from ZeroMQ subscriber");
-            break;
-        }
+    char topic[256];
+    while (1) {
+        if (shared_state) {
+            // The seqlock always holds the newest state, so wait out the frame interval first
+            long delay = frame_delay_ms(&cache);
+            if (delay > 0) usleep(delay * 1000);
 
-        if (zmq_recv(subscriber, &gameState, sizeof(GameState), 0) == -1) {
-            perror("Failed to receive game state from ZeroMQ subscriber");
-            break;
-        }
+            int received = shared_state_read(shared_state, &shared_seq, decoded[0], sizeof(decoded[0]));
+            if (received == -1 || (received == 1 && snapshot_check(decoded[0], sizeof(decoded[0]), BOARD_SIZE) != 0)) {
+                fprintf(stderr, "Shared memory holds an unsupported snapshot\n");
+                break;
+            }
+            if (received == 0) {
+                break;
+            }
+            snapshot = decoded[0];
+            frame_pending = 1;
+        } else {
+            // Wait for the next update, or until a held-back frame is due
+            zmq_pollitem_t items[] = {{subscriber, 0, ZMQ_POLLIN, 0}, {latest_sub, 0, ZMQ_POLLIN, 0}};
+            if (zmq_poll(items, latest_only ? 2 : 1, frame_pending ? frame_delay_ms(&cache) : -1) == -1) {
+                perror("Failed to poll ZeroMQ subscriber");
+                break;
+            }
 
-        wclear(score_win);
-        box(score_win, 0, 0);
-        mvwprintw(score_win, 1, 3, "%s", "SCORE");
+            if (latest_only && (items[1].revents & ZMQ_POLLIN)) {
+                int received = receive_snapshot(latest_sub, &current, strlen(MSG_LATEST), &snapshot);
+                if (received == -1) {
+                    perror("Failed to receive latest state from ZeroMQ subscriber");
+                    break;
+                }
+                if (received) frame_pending = 1;
+            }
 
-        for (int i = 0; i < BOARD_SIZE; i++) {
-            for (int j = 0; j < BOARD_SIZE; j++) {
-                mvwaddch(board_win, i + 1, j + 1, gameState.board[i][j]);
+            if (items[0].revents & ZMQ_POLLIN) {
+                if (zmq_recv(subscriber, topic, sizeof(topic), 0) == -1) {
+                    perror("Failed to receive topic from ZeroMQ subscriber");
+                    break;
+                }
+
+                if (strncmp(topic, MSG_SERVER, strlen(MSG_SERVER)) == 0) {
+                    break;
+                }
+
+                if (overview_only && strncmp(topic, MSG_OVERVIEW, strlen(MSG_OVERVIEW)) == 0) {
+                    uint8_t record[OVERVIEW_RECORD_SIZE(OVERVIEW_SIDE, MAX_PLAYERS)];
+                    int size = zmq_recv(subscriber, record, sizeof(record), 0);
+                    if (size == -1) {
+                        perror("Failed to receive overview from ZeroMQ subscriber");
+                        break;
+                    }
+                    if (size != (int)sizeof(record)) continue; // Overview of another layout
+                    decode_overview(record, &overview);
+                    frame_pending = 1;
+                } else if (codec != -1 && strncmp(topic, MSG_COMPRESSED, strlen(MSG_COMPRESSED)) == 0) {
+                    int received = receive_compressed(subscriber, decoded, &snapshot);
+                    if (received == -1) {
+                        perror("Failed to receive compressed state from ZeroMQ subscriber");
+                        break;
+                    }
+                    if (received) frame_pending = 1;
+                } else if (strncmp(topic, MSG_UPDATE, strlen(MSG_UPDATE)) == 0) {
+                    int received = receive_snapshot(subscriber, &current, 0, &snapshot);
+                    if (received == -1) {
+                        perror("Failed to receive game state from ZeroMQ subscriber");
+                        break;
+                    }
+                    if (received) frame_pending = 1;
+                }
             }
         }
 
+        // Frames arriving faster than MAX_FRAME_RATE are coalesced
+        if (!frame_pending || frame_delay_ms(&cache) > 0) {
+            continue;
+        }
+        frame_pending = 0;
+        if (!overview_only && !snapshot) {
+            continue;
+        }
+
+        char lines[MAX_PLAYERS][SCORE_LINE_WIDTH + 1];
         int j = 0;
-        for (int i = 0; i < MAX_PLAYERS; i++) {
-            if (astronaut_ids_in_use[i]) {
-                mvwprintw(score_win, 2 + j, 3, "%c - %d", gameState.astronauts[i].id, gameState.astronauts[i].score);
-                j++;
+        const char *board;
+        if (overview_only) {
+            render_heatmap(&overview, heatmap);
+            board = &heatmap[0][0];
+            for (int i = 0; i < MAX_PLAYERS; i++) {
+                if (overview.ids[i]) {
+                    snprintf(lines[j], sizeof(lines[j]), "%c - %d", overview.ids[i], overview.scores[i]);
+                    j++;
+                }
+            }
+        } else {
+            board = snapshot_board(snapshot);
+            for (int i = 0; i < snapshot_slots(snapshot) && j < MAX_PLAYERS; i++) {
+                if (snapshot_player_in_use(snapshot, i)) {
+                    snprintf(lines[j], sizeof(lines[j]), "%c - %d", snapshot_player_id(snapshot, i), snapshot_player_score(snapshot, i));
+                    j++;
+                }
             }
         }
 
-        refresh();
-        wrefresh(board_win);
-        wrefresh(score_win);
-        wrefresh(line_win);
-        wrefresh(column_win);
+        render_board_diff(board_win, &cache, (const char (*)[BOARD_SIZE])board);
+        render_scores_diff(score_win, &cache, lines, j);
+        render_flush(&cache, board_win, score_win);
     }
 
     // Cleanup
@@ -166,6 +419,12 @@ void display_game_state() {
 
     endwin();
 
+    zmq_msg_close(&current);
+
+    if (latest_sub && zmq_close(latest_sub) != 0) {
+        perror("Failed to close ZeroMQ latest-state subscriber socket");
+    }
+
     if (zmq_close(subscriber) != 0) {
         perror("Failed to close ZeroMQ subscriber socket");
     }
@@ -176,7 +435,43 @@ void display_game_state() {
 }
 
 
-int main() {
+/**
+ * Entry point for the outer space display.
+ *
+ * Passing --overview renders the low-detail overview as a heatmap,
+ * --codec NAME receives states compressed with the named codec (rle, or
+ * zstd when built with it),
+ * --latest enables the latest-state-only subscription mode, and
+ * --shm reads states from the shared memory segment of a server on the
+ * same host.
+ *
+ * @return Returns 0 upon completion.
+ */
+int main(int argc, char *argv[]) {
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--overview") == 0) overview_only = 1;
+        if (strcmp(argv[i], "--latest") == 0) latest_only = 1;
+        if (strcmp(argv[i], "--codec") == 0 && i + 1 < argc) {
+            codec = codec_lookup(argv[i + 1], strlen(argv[i + 1]));
+            if (codec == -1 || !codec_available(codec)) {
+                fprintf(stderr, "Codec %s is not available\n", argv[i + 1]);
+                return 1;
+            }
+            i++;
+        }
+        if (strcmp(argv[i], "--shm") == 0 && !(shared_state = shared_state_map(0))) {
+            perror("Failed to map shared memory state");
+            return 1;
+        }
+    }
+
+    if (codec != -1 && codec_init(&codecs) != 0) {
+        perror("Failed to set up the frame codec");
+        return 1;
+    }
+
     display_game_state();
+    codec_free(&codecs);
+    if (shared_state) shared_state_unmap(shared_state, 0);
     return 0;
 }
@@ -0,0 +1,159 @@
+#ifndef RULES_BATCH_H
+#define RULES_BATCH_H
+
+// Many independent games stepped in lockstep, for training and evaluating
+// automated players. The boards are one contiguous array of RulesState,
+// and every step takes one action per astronaut of every board from a flat
+// array and writes the boards, scores and rewards back into flat
+// observation buffers, so a trainer can hand them to its model as they are.
+//
+// rules_batch_step() works on a range of boards, so callers split a batch
+// across threads without any locking: boards never share memory. Each
+// board runs the same game-rules.h code as the server, so a policy
+// trained here plays the real game.
+
+#include <stdint.h>  // for uint8_t, uint32_t, int32_t
+#include <stdlib.h>  // for calloc, free
+#include <string.h>  // for memcpy, memset
+
+#include "game-rules.h"
+
+// Actions of an astronaut during one step
+enum { BATCH_IDLE, BATCH_UP, BATCH_DOWN, BATCH_LEFT, BATCH_RIGHT, BATCH_ZAP, BATCH_ACTIONS };
+
+typedef struct {
+    int count;             // Boards
+    int players;           // Astronauts on every board, in slots 0 to players - 1
+    uint32_t seed;         // Seed of the whole batch
+    RulesState *boards;    // count boards
+    char *observations;    // count boards of BOARD_SIZE * BOARD_SIZE cells, after the last step
+    int32_t *scores;       // count * MAX_PLAYERS scores, after the last step
+    int32_t *rewards;      // count * MAX_PLAYERS aliens hit during the last step
+    uint8_t *done;         // Set for a board whose aliens are all gone; it restarts on the next step
+    uint32_t *episodes;    // Games finished on each board
+} RulesBatch;
+
+/**
+ * Starts a new game on one board, with the batch's astronauts connected.
+ *
+ * The game's seed depends on the batch seed, the board and how many games
+ * the board finished, so a batch always replays the same games.
+ *
+ * @param batch Pointer to the RulesBatch.
+ * @param board Index of the board.
+ */
+static inline void rules_batch_reset_board(RulesBatch *batch, int board) {
+    RulesState *state = &batch->boards[board];
+    uint32_t seed = batch->seed ^ (uint32_t)board * 2654435761u ^ batch->episodes[board] * 40503u;
+    rules_init(state, seed, 0);
+
+    RulesCommand connect = {RULES_CONNECT, 0, 0, {0}, 0, 0};
+    RulesResult result;
+    for (int p = 0; p < batch->players; p++) rules_apply(state, &connect, &result, NULL);
+
+    memcpy(batch->observations + (size_t)board * BOARD_SIZE * BOARD_SIZE, state->game.board,
+           BOARD_SIZE * BOARD_SIZE);
+    memset(batch->scores + (size_t)board * MAX_PLAYERS, 0, MAX_PLAYERS * sizeof(int32_t));
+    memset(batch->rewards + (size_t)board * MAX_PLAYERS, 0, MAX_PLAYERS * sizeof(int32_t));
+    batch->done[board] = 0;
+}
+
+/**
+ * Frees the buffers of a batch.
+ *
+ * @param batch Pointer to the RulesBatch.
+ */
+static inline void rules_batch_free(RulesBatch *batch) {
+    free(batch->boards);
+    free(batch->observations);
+    free(batch->scores);
+    free(batch->rewards);
+    free(batch->done);
+    free(batch->episodes);
+    memset(batch, 0, sizeof(*batch));
+}
+
+/**
+ * Allocates a batch and starts a game on every board.
+ *
+ * @param batch Pointer to the RulesBatch to be initialized.
+ * @param count Number of boards.
+ * @param players Astronauts on every board, from 1 to MAX_PLAYERS.
+ * @param seed Seed of the batch.
+ * @return 0 on success, -1 if the arguments are invalid or memory could not be allocated.
+ */
+static inline int rules_batch_init(RulesBatch *batch, int count, int players, uint32_t seed) {
+    memset(batch, 0, sizeof(*batch));
+    if (count <= 0 || players < 1 || players > MAX_PLAYERS) return -1;
+
+    batch->count = count;
+    batch->players = players;
+    batch->seed = seed;
+    batch->boards = (RulesState *)calloc(count, sizeof(RulesState));
+    batch->observations = (char *)calloc(count, BOARD_SIZE * BOARD_SIZE);
+    batch->scores = (int32_t *)calloc((size_t)count * MAX_PLAYERS, sizeof(int32_t));
+    batch->rewards = (int32_t *)calloc((size_t)count * MAX_PLAYERS, sizeof(int32_t));
+    batch->done = (uint8_t *)calloc(count, 1);
+    batch->episodes = (uint32_t *)calloc(count, sizeof(uint32_t));
+    if (!batch->boards || !batch->observations || !batch->scores || !batch->rewards || !batch->done ||
+        !batch->episodes) {
+        rules_batch_free(batch);
+        return -1;
+    }
+
+    for (int board = 0; board < count; board++) rules_batch_reset_board(batch, board);
+    return 0;
+}
+
+/**
+ * Steps a range of boards once.
+ *
+ * Boards marked done restart first. Then the actions of each astronaut are
+ * applied, the clock advances by dt, and the observation buffers of the
+ * range are rewritten.
+ *
+ * @param batch Pointer to the RulesBatch.
+ * @param actions count * MAX_PLAYERS actions, BATCH_IDLE for empty slots.
+ * @param dt Seconds each board advances by; 1 moves the aliens every step.
+ * @param first First board of the range.
+ * @param last One past the last board of the range.
+ */
+static inline void rules_batch_step(RulesBatch *batch, const uint8_t *actions, double dt, int first, int last) {
+    for (int board = first; board < last; board++) {
+        RulesState *state = &batch->boards[board];
+        if (batch->done[board]) {
+            batch->episodes[board]++;
+            rules_batch_reset_board(batch, board);
+        }
+
+        RulesCommand commands[MAX_PLAYERS];
+        RulesResult results[MAX_PLAYERS];
+        int count = 0;
+        for (int p = 0; p < batch->players; p++) {
+            uint8_t action = actions[(size_t)board * MAX_PLAYERS + p];
+            if (action == BATCH_IDLE || action >= BATCH_ACTIONS) continue;
+
+            RulesCommand *command = &commands[count++];
+            command->type = action == BATCH_ZAP ? RULES_ZAP : RULES_MOVE;
+            command->id = (char)('A' + p);
+            command->direction = "?UDLR"[action < BATCH_ZAP ? action : 0];
+            memcpy(command->token, state->tokens[p], TOKEN_SIZE);
+            command->seq = 0;
+            command->tick = 0;
+        }
+        rules_step(state, commands, count, dt, results, NULL);
+
+        int32_t *rewards = batch->rewards + (size_t)board * MAX_PLAYERS;
+        int32_t *scores = batch->scores + (size_t)board * MAX_PLAYERS;
+        memset(rewards, 0, MAX_PLAYERS * sizeof(int32_t));
+        for (int i = 0; i < count; i++) {
+            if (results[i].slot >= 0) rewards[results[i].slot] += results[i].points;
+        }
+        for (int p = 0; p < MAX_PLAYERS; p++) scores[p] = state->game.astronauts[p].score;
+        memcpy(batch->observations + (size_t)board * BOARD_SIZE * BOARD_SIZE, state->game.board,
+               BOARD_SIZE * BOARD_SIZE);
+        batch->done[board] = state->game.alien_count == 0;
+    }
+}
+
+#endif
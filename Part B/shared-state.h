@@ -0,0 +1,145 @@
+#ifndef SHARED_STATE_H
+#define SHARED_STATE_H
+
+// Game state snapshot shared with same-host readers through POSIX shared
+// memory. A single writer (the game server) publishes each update, in the
+// snapshot.h format, under a seqlock; readers copy it out without syscalls
+// and sleep on the sequence word with a futex while nothing changes. Usable
+// from C and C++.
+
+#include <fcntl.h>         // for O_CREAT, O_RDWR, O_RDONLY
+#include <linux/futex.h>   // for FUTEX_WAIT, FUTEX_WAKE
+#include <stdint.h>        // for uint32_t
+#include <string.h>        // for memcpy
+#include <sys/mman.h>      // for shm_open, mmap, munmap, shm_unlink
+#include <sys/syscall.h>   // for SYS_futex
+#include <unistd.h>        // for ftruncate, close, syscall
+
+#define SHM_STATE_NAME "/space-invaders-state"
+#define SHM_STATE_MAX 8192  // Bytes reserved for the snapshot
+
+typedef struct {
+    uint32_t seq;         // Odd while the writer is updating; futex word
+    uint32_t terminated;  // Set when the server shuts down
+    uint32_t state_size;  // Size of the current snapshot
+    unsigned char state[SHM_STATE_MAX];
+} SharedState;
+
+/**
+ * Maps the shared state segment.
+ *
+ * @param writer Non-zero to create the segment for writing (game server),
+ *               zero to open an existing one read-only.
+ * @return Pointer to the mapped segment, or NULL on failure.
+ */
+static inline SharedState *shared_state_map(int writer) {
+    int fd = shm_open(SHM_STATE_NAME, writer ? O_CREAT | O_RDWR : O_RDONLY, 0644);
+    if (fd == -1) return NULL;
+    if (writer && ftruncate(fd, sizeof(SharedState)) == -1) {
+        close(fd);
+        return NULL;
+    }
+
+    void *segment = mmap(NULL, sizeof(SharedState), writer ? PROT_READ | PROT_WRITE : PROT_READ,
+                         MAP_SHARED, fd, 0);
+    close(fd);
+    if (segment == MAP_FAILED) return NULL;
+
+    // A restarted server reuses the segment, keeping the sequence counting up.
+    // A writer that died mid-update left it odd, which readers would wait on
+    // forever, so it is rounded up to the next even value.
+    if (writer) {
+        SharedState *shared = (SharedState *)segment;
+        uint32_t seq = __atomic_load_n(&shared->seq, __ATOMIC_RELAXED);
+        __atomic_store_n(&shared->seq, (seq + 1) & ~1u, __ATOMIC_RELEASE);
+        __atomic_store_n(&shared->terminated, 0, __ATOMIC_RELEASE);
+        syscall(SYS_futex, &shared->seq, FUTEX_WAKE, INT32_MAX, NULL, NULL, 0);
+    }
+    return (SharedState *)segment;
+}
+
+/**
+ * Unmaps the shared state segment, removing it if the caller is the writer.
+ *
+ * @param shared Pointer to the mapped segment.
+ * @param writer Non-zero if the caller created the segment.
+ */
+static inline void shared_state_unmap(SharedState *shared, int writer) {
+    munmap(shared, sizeof(SharedState));
+    if (writer) shm_unlink(SHM_STATE_NAME);
+}
+
+/**
+ * Publishes a new snapshot and wakes every waiting reader.
+ *
+ * Only one thread may write at a time.
+ *
+ * @param shared Pointer to the segment mapped for writing.
+ * @param state Pointer to the snapshot.
+ * @param size Size of the snapshot, at most SHM_STATE_MAX.
+ */
+static inline void shared_state_write(SharedState *shared, const void *state, uint32_t size) {
+    uint32_t seq = __atomic_load_n(&shared->seq, __ATOMIC_RELAXED);
+    __atomic_store_n(&shared->seq, seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    shared->state_size = size;
+    memcpy(shared->state, state, size);
+
+    __atomic_store_n(&shared->seq, seq + 2, __ATOMIC_RELEASE);
+    syscall(SYS_futex, &shared->seq, FUTEX_WAKE, INT32_MAX, NULL, NULL, 0);
+}
+
+/**
+ * Marks the segment as terminated and wakes every waiting reader.
+ *
+ * @param shared Pointer to the segment mapped for writing.
+ */
+static inline void shared_state_terminate(SharedState *shared) {
+    __atomic_store_n(&shared->terminated, 1, __ATOMIC_RELEASE);
+    __atomic_add_fetch(&shared->seq, 2, __ATOMIC_RELEASE);
+    syscall(SYS_futex, &shared->seq, FUTEX_WAKE, INT32_MAX, NULL, NULL, 0);
+}
+
+/**
+ * Waits for a snapshot newer than the last one read and copies it out.
+ *
+ * The copy is retried if the writer updated the segment meanwhile, so the
+ * caller always gets a consistent snapshot. The futex wait is the only
+ * syscall, and it only happens when no newer snapshot is available. The
+ * copy is still needed here: reading in place would race with the writer.
+ *
+ * @param shared Pointer to the mapped segment.
+ * @param last_seq Sequence of the last snapshot read, updated on success.
+ * @param state Destination for the snapshot.
+ * @param capacity Size of the destination.
+ * @return 1 on success, 0 if the server terminated, -1 if the snapshot
+ *         does not fit the destination.
+ */
+static inline int shared_state_read(const SharedState *shared, uint32_t *last_seq, void *state,
+                                    uint32_t capacity) {
+    while (1) {
+        uint32_t seq = __atomic_load_n(&shared->seq, __ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&shared->terminated, __ATOMIC_ACQUIRE)) return 0;
+
+        if (seq == *last_seq || (seq & 1)) {
+            syscall(SYS_futex, &shared->seq, FUTEX_WAIT, seq, NULL, NULL, 0);
+            continue;
+        }
+
+        uint32_t size = __atomic_load_n(&shared->state_size, __ATOMIC_RELAXED);
+        if (size > capacity) {
+            if (__atomic_load_n(&shared->seq, __ATOMIC_ACQUIRE) == seq) return -1;
+            continue;  // Torn read of the size
+        }
+        memcpy(state, shared->state, size);
+
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&shared->seq, __ATOMIC_RELAXED) == seq) {
+            *last_seq = seq;
+            return 1;
+        }
+    }
+}
+
+#endif
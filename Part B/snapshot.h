@@ -0,0 +1,405 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+// Versioned binary snapshot of the game state, shared by the C programs and
+// the C++ space-high-scores. Every field lives at a fixed offset and is
+// stored little-endian, so readers access it in place (straight from a ZeroMQ
+// message or the shared memory segment) without depending on the writer's
+// struct layout, padding or time_t size.
+//
+// Layout:
+//   header   SNAPSHOT_HEADER_SIZE bytes, see the SNAPSHOT_*_OFFSET fields
+//   players  player_slots records of SNAPSHOT_PLAYER_SIZE bytes
+//   board    board_size * board_size characters, row by row
+//   aliens   alien_count records of SNAPSHOT_ALIEN_SIZE bytes
+//
+// Readers reject other major versions. Fields may be appended to the header
+// without a version change: readers take section offsets from header_size
+// and ignore the bytes they do not know.
+//
+// The smaller records published on their own topics, board tiles and the
+// dashboard overview, use the same fixed-offset little-endian encoding.
+
+#include <stddef.h>  // for size_t
+#include <stdint.h>  // for uint8_t, uint16_t, uint32_t, uint64_t
+
+#define SNAPSHOT_MAGIC 0x534e4953u  // "SINS" as stored on the wire
+#define SNAPSHOT_VERSION 1
+
+#define SNAPSHOT_MAGIC_OFFSET 0        // u32
+#define SNAPSHOT_VERSION_OFFSET 4      // u16
+#define SNAPSHOT_HEADER_SIZE_OFFSET 6  // u16
+#define SNAPSHOT_TOTAL_SIZE_OFFSET 8   // u32, header and every section
+#define SNAPSHOT_BOARD_SIZE_OFFSET 12  // u16
+#define SNAPSHOT_SLOTS_OFFSET 14       // u16, player slots
+#define SNAPSHOT_ALIENS_OFFSET 16      // u16, alien count
+#define SNAPSHOT_ASTRONAUTS_OFFSET 18  // u16, astronaut count
+#define SNAPSHOT_SEQ_OFFSET 20         // u32, publish sequence number
+#define SNAPSHOT_EPOCH_OFFSET 24       // u32, start time of the publishing server
+#define SNAPSHOT_TICK_OFFSET 28        // u64, alien moves made in the game so far
+#define SNAPSHOT_HEADER_SIZE 36
+#define SNAPSHOT_MIN_HEADER_SIZE 20    // Header of writers without the sequence fields
+
+// Player record
+#define SNAPSHOT_PLAYER_ID 0        // u8, astronaut ID
+#define SNAPSHOT_PLAYER_IN_USE 1    // u8
+#define SNAPSHOT_PLAYER_FLAGS 2     // u8, SNAPSHOT_STUNNED
+#define SNAPSHOT_PLAYER_X 4         // u16
+#define SNAPSHOT_PLAYER_Y 6         // u16
+#define SNAPSHOT_PLAYER_SCORE 8     // u32, two's complement
+#define SNAPSHOT_PLAYER_LAST_SEQ 12 // u32
+#define SNAPSHOT_PLAYER_SIZE 16
+
+#define SNAPSHOT_STUNNED 0x01
+
+// Tile record, the payload of a tile topic: one square of the board
+#define TILE_RECORD_ROW 0        // u8, tile coordinates, in tiles
+#define TILE_RECORD_COL 1        // u8
+#define TILE_RECORD_SEQ 4        // u32, updates of this tile sent so far
+#define TILE_RECORD_STATE_SEQ 8  // u32, snapshot sequence number of the same publish
+#define TILE_RECORD_EPOCH 12     // u32, start time of the publishing server
+#define TILE_RECORD_CELLS 16     // side * side characters, row by row
+#define TILE_RECORD_SIZE(side) (TILE_RECORD_CELLS + (side) * (side))
+
+// Overview record, the payload of the overview topic:
+//   density  side * side u8, aliens in each block, row by row
+//   players  slots records of OVERVIEW_PLAYER_SIZE bytes
+#define OVERVIEW_PLAYER_ID 0     // u8, astronaut ID, 0 if the slot is free
+#define OVERVIEW_PLAYER_SCORE 1  // u32, two's complement
+#define OVERVIEW_PLAYER_SIZE 5
+#define OVERVIEW_RECORD_SIZE(side, slots) ((side) * (side) + (slots) * OVERVIEW_PLAYER_SIZE)
+
+// Alien record
+#define SNAPSHOT_ALIEN_X 0  // u8
+#define SNAPSHOT_ALIEN_Y 1  // u8
+#define SNAPSHOT_ALIEN_SIZE 2
+
+static inline uint16_t snapshot_u16(const uint8_t *p) {
+    return (uint16_t)(p[0] | p[1] << 8);
+}
+
+static inline uint32_t snapshot_u32(const uint8_t *p) {
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static inline uint64_t snapshot_u64(const uint8_t *p) {
+    return (uint64_t)snapshot_u32(p) | (uint64_t)snapshot_u32(p + 4) << 32;
+}
+
+static inline void snapshot_put16(uint8_t *p, uint16_t value) {
+    p[0] = (uint8_t)value;
+    p[1] = (uint8_t)(value >> 8);
+}
+
+static inline void snapshot_put32(uint8_t *p, uint32_t value) {
+    p[0] = (uint8_t)value;
+    p[1] = (uint8_t)(value >> 8);
+    p[2] = (uint8_t)(value >> 16);
+    p[3] = (uint8_t)(value >> 24);
+}
+
+static inline void snapshot_put64(uint8_t *p, uint64_t value) {
+    snapshot_put32(p, (uint32_t)value);
+    snapshot_put32(p + 4, (uint32_t)(value >> 32));
+}
+
+/**
+ * Returns the size of a snapshot.
+ *
+ * @param board_size Side of the board.
+ * @param slots Number of player slots.
+ * @param aliens Number of aliens.
+ * @return Size of the snapshot in bytes.
+ */
+static inline size_t snapshot_size(int board_size, int slots, int aliens) {
+    return SNAPSHOT_HEADER_SIZE + (size_t)slots * SNAPSHOT_PLAYER_SIZE +
+           (size_t)board_size * board_size + (size_t)aliens * SNAPSHOT_ALIEN_SIZE;
+}
+
+/**
+ * Checks that a buffer holds a complete snapshot this reader understands.
+ *
+ * Every other accessor assumes the snapshot passed this check.
+ *
+ * @param buffer The received bytes.
+ * @param size Number of bytes received.
+ * @param board_size Side of the reader's board; 0 accepts any size.
+ * @return 0 if the snapshot can be read, -1 otherwise.
+ */
+static inline int snapshot_check(const void *buffer, size_t size, int board_size) {
+    const uint8_t *s = (const uint8_t *)buffer;
+    if (size < SNAPSHOT_MIN_HEADER_SIZE || snapshot_u32(s + SNAPSHOT_MAGIC_OFFSET) != SNAPSHOT_MAGIC ||
+        snapshot_u16(s + SNAPSHOT_VERSION_OFFSET) != SNAPSHOT_VERSION) {
+        return -1;
+    }
+
+    size_t header = snapshot_u16(s + SNAPSHOT_HEADER_SIZE_OFFSET);
+    int board = snapshot_u16(s + SNAPSHOT_BOARD_SIZE_OFFSET);
+    size_t total = header + (snapshot_size(board, snapshot_u16(s + SNAPSHOT_SLOTS_OFFSET),
+                                           snapshot_u16(s + SNAPSHOT_ALIENS_OFFSET)) - SNAPSHOT_HEADER_SIZE);
+    if (header < SNAPSHOT_MIN_HEADER_SIZE || snapshot_u32(s + SNAPSHOT_TOTAL_SIZE_OFFSET) != total || total > size) {
+        return -1;
+    }
+    return board_size && board != board_size ? -1 : 0;
+}
+
+static inline int snapshot_board_size(const void *snapshot) {
+    return snapshot_u16((const uint8_t *)snapshot + SNAPSHOT_BOARD_SIZE_OFFSET);
+}
+
+static inline int snapshot_slots(const void *snapshot) {
+    return snapshot_u16((const uint8_t *)snapshot + SNAPSHOT_SLOTS_OFFSET);
+}
+
+static inline int snapshot_alien_count(const void *snapshot) {
+    return snapshot_u16((const uint8_t *)snapshot + SNAPSHOT_ALIENS_OFFSET);
+}
+
+static inline int snapshot_astronaut_count(const void *snapshot) {
+    return snapshot_u16((const uint8_t *)snapshot + SNAPSHOT_ASTRONAUTS_OFFSET);
+}
+
+static inline size_t snapshot_total_size(const void *snapshot) {
+    return snapshot_u32((const uint8_t *)snapshot + SNAPSHOT_TOTAL_SIZE_OFFSET);
+}
+
+/**
+ * Returns the publish sequence number of a snapshot.
+ *
+ * Sequence numbers grow by one with every state the server publishes and
+ * restart with the server, which then has a new epoch.
+ *
+ * @param snapshot A checked snapshot.
+ * @return The sequence number, 0 if the writer did not set one.
+ */
+static inline uint32_t snapshot_seq(const void *snapshot) {
+    const uint8_t *s = (const uint8_t *)snapshot;
+    return snapshot_u16(s + SNAPSHOT_HEADER_SIZE_OFFSET) >= SNAPSHOT_SEQ_OFFSET + 4 ? snapshot_u32(s + SNAPSHOT_SEQ_OFFSET) : 0;
+}
+
+static inline uint32_t snapshot_epoch(const void *snapshot) {
+    const uint8_t *s = (const uint8_t *)snapshot;
+    return snapshot_u16(s + SNAPSHOT_HEADER_SIZE_OFFSET) >= SNAPSHOT_EPOCH_OFFSET + 4 ? snapshot_u32(s + SNAPSHOT_EPOCH_OFFSET) : 0;
+}
+
+/**
+ * Returns the tick of the aliens shown, which a player sends back with a
+ * zap so the server resolves it against what they saw.
+ *
+ * @param snapshot A checked snapshot.
+ * @return The tick, 0 if the writer did not set one.
+ */
+static inline uint64_t snapshot_tick(const void *snapshot) {
+    const uint8_t *s = (const uint8_t *)snapshot;
+    return snapshot_u16(s + SNAPSHOT_HEADER_SIZE_OFFSET) >= SNAPSHOT_TICK_OFFSET + 8 ? snapshot_u64(s + SNAPSHOT_TICK_OFFSET) : 0;
+}
+
+/**
+ * Returns the record of a player slot, in place.
+ *
+ * @param snapshot A checked snapshot.
+ * @param slot Player slot, below snapshot_slots.
+ * @return Pointer to the record, read with the SNAPSHOT_PLAYER_* offsets.
+ */
+static inline const uint8_t *snapshot_player(const void *snapshot, int slot) {
+    const uint8_t *s = (const uint8_t *)snapshot;
+    return s + snapshot_u16(s + SNAPSHOT_HEADER_SIZE_OFFSET) + (size_t)slot * SNAPSHOT_PLAYER_SIZE;
+}
+
+static inline int snapshot_player_in_use(const void *snapshot, int slot) {
+    return snapshot_player(snapshot, slot)[SNAPSHOT_PLAYER_IN_USE];
+}
+
+static inline char snapshot_player_id(const void *snapshot, int slot) {
+    return (char)snapshot_player(snapshot, slot)[SNAPSHOT_PLAYER_ID];
+}
+
+static inline int snapshot_player_x(const void *snapshot, int slot) {
+    return snapshot_u16(snapshot_player(snapshot, slot) + SNAPSHOT_PLAYER_X);
+}
+
+static inline int snapshot_player_y(const void *snapshot, int slot) {
+    return snapshot_u16(snapshot_player(snapshot, slot) + SNAPSHOT_PLAYER_Y);
+}
+
+static inline int snapshot_player_score(const void *snapshot, int slot) {
+    return (int32_t)snapshot_u32(snapshot_player(snapshot, slot) + SNAPSHOT_PLAYER_SCORE);
+}
+
+static inline unsigned int snapshot_player_last_seq(const void *snapshot, int slot) {
+    return snapshot_u32(snapshot_player(snapshot, slot) + SNAPSHOT_PLAYER_LAST_SEQ);
+}
+
+static inline int snapshot_player_stunned(const void *snapshot, int slot) {
+    return snapshot_player(snapshot, slot)[SNAPSHOT_PLAYER_FLAGS] & SNAPSHOT_STUNNED;
+}
+
+/**
+ * Returns the board cells, in place.
+ *
+ * @param snapshot A checked snapshot.
+ * @return Pointer to board_size rows of board_size characters.
+ */
+static inline const char *snapshot_board(const void *snapshot) {
+    return (const char *)snapshot_player(snapshot, snapshot_slots(snapshot));
+}
+
+/**
+ * Returns the record of an alien, in place.
+ *
+ * @param snapshot A checked snapshot.
+ * @param index Alien index, below snapshot_alien_count.
+ * @return Pointer to the record, read with the SNAPSHOT_ALIEN_* offsets.
+ */
+static inline const uint8_t *snapshot_alien(const void *snapshot, int index) {
+    int board = snapshot_board_size(snapshot);
+    return (const uint8_t *)snapshot_board(snapshot) + (size_t)board * board + (size_t)index * SNAPSHOT_ALIEN_SIZE;
+}
+
+/**
+ * Starts writing a snapshot; the caller then fills every player slot, the
+ * board and the aliens.
+ *
+ * @param buffer Destination, at least snapshot_size bytes.
+ * @param board_size Side of the board.
+ * @param slots Number of player slots.
+ * @param aliens Number of aliens.
+ * @param astronauts Number of astronauts.
+ * @return Size of the snapshot in bytes.
+ */
+static inline size_t snapshot_begin(void *buffer, int board_size, int slots, int aliens, int astronauts) {
+    uint8_t *s = (uint8_t *)buffer;
+    size_t size = snapshot_size(board_size, slots, aliens);
+
+    snapshot_put32(s + SNAPSHOT_MAGIC_OFFSET, SNAPSHOT_MAGIC);
+    snapshot_put16(s + SNAPSHOT_VERSION_OFFSET, SNAPSHOT_VERSION);
+    snapshot_put16(s + SNAPSHOT_HEADER_SIZE_OFFSET, SNAPSHOT_HEADER_SIZE);
+    snapshot_put32(s + SNAPSHOT_TOTAL_SIZE_OFFSET, (uint32_t)size);
+    snapshot_put16(s + SNAPSHOT_BOARD_SIZE_OFFSET, (uint16_t)board_size);
+    snapshot_put16(s + SNAPSHOT_SLOTS_OFFSET, (uint16_t)slots);
+    snapshot_put16(s + SNAPSHOT_ALIENS_OFFSET, (uint16_t)aliens);
+    snapshot_put16(s + SNAPSHOT_ASTRONAUTS_OFFSET, (uint16_t)astronauts);
+    snapshot_put32(s + SNAPSHOT_SEQ_OFFSET, 0);
+    snapshot_put32(s + SNAPSHOT_EPOCH_OFFSET, 0);
+    snapshot_put64(s + SNAPSHOT_TICK_OFFSET, 0);
+    return size;
+}
+
+/**
+ * Stamps a snapshot with its position in the published stream.
+ */
+static inline void snapshot_set_sequence(void *buffer, uint32_t epoch, uint32_t seq) {
+    snapshot_put32((uint8_t *)buffer + SNAPSHOT_SEQ_OFFSET, seq);
+    snapshot_put32((uint8_t *)buffer + SNAPSHOT_EPOCH_OFFSET, epoch);
+}
+
+/**
+ * Stamps a snapshot with the tick of its aliens.
+ */
+static inline void snapshot_set_tick(void *buffer, uint64_t tick) {
+    snapshot_put64((uint8_t *)buffer + SNAPSHOT_TICK_OFFSET, tick);
+}
+
+/**
+ * Writes the record of a player slot.
+ */
+static inline void snapshot_set_player(void *buffer, int slot, char id, int in_use, int flags,
+                                       int x, int y, int score, unsigned int last_seq) {
+    uint8_t *p = (uint8_t *)snapshot_player(buffer, slot);
+    p[SNAPSHOT_PLAYER_ID] = (uint8_t)id;
+    p[SNAPSHOT_PLAYER_IN_USE] = (uint8_t)(in_use != 0);
+    p[SNAPSHOT_PLAYER_FLAGS] = (uint8_t)flags;
+    p[3] = 0;
+    snapshot_put16(p + SNAPSHOT_PLAYER_X, (uint16_t)x);
+    snapshot_put16(p + SNAPSHOT_PLAYER_Y, (uint16_t)y);
+    snapshot_put32(p + SNAPSHOT_PLAYER_SCORE, (uint32_t)score);
+    snapshot_put32(p + SNAPSHOT_PLAYER_LAST_SEQ, last_seq);
+}
+
+/**
+ * Returns the board cells for writing.
+ */
+static inline char *snapshot_board_mut(void *buffer) {
+    return (char *)snapshot_board(buffer);
+}
+
+/**
+ * Writes the record of an alien.
+ */
+static inline void snapshot_set_alien(void *buffer, int index, int x, int y) {
+    uint8_t *p = (uint8_t *)snapshot_alien(buffer, index);
+    p[SNAPSHOT_ALIEN_X] = (uint8_t)x;
+    p[SNAPSHOT_ALIEN_Y] = (uint8_t)y;
+}
+
+/**
+ * Writes the fields of a tile record; the caller fills its cells.
+ *
+ * @return The cells of the tile, row by row.
+ */
+static inline char *tile_record_begin(void *buffer, int row, int col, uint32_t seq, uint32_t state_seq,
+                                      uint32_t epoch) {
+    uint8_t *p = (uint8_t *)buffer;
+    p[TILE_RECORD_ROW] = (uint8_t)row;
+    p[TILE_RECORD_COL] = (uint8_t)col;
+    p[2] = p[3] = 0;
+    snapshot_put32(p + TILE_RECORD_SEQ, seq);
+    snapshot_put32(p + TILE_RECORD_STATE_SEQ, state_seq);
+    snapshot_put32(p + TILE_RECORD_EPOCH, epoch);
+    return (char *)p + TILE_RECORD_CELLS;
+}
+
+static inline int tile_record_row(const void *record) {
+    return ((const uint8_t *)record)[TILE_RECORD_ROW];
+}
+
+static inline int tile_record_col(const void *record) {
+    return ((const uint8_t *)record)[TILE_RECORD_COL];
+}
+
+static inline uint32_t tile_record_seq(const void *record) {
+    return snapshot_u32((const uint8_t *)record + TILE_RECORD_SEQ);
+}
+
+static inline uint32_t tile_record_state_seq(const void *record) {
+    return snapshot_u32((const uint8_t *)record + TILE_RECORD_STATE_SEQ);
+}
+
+static inline uint32_t tile_record_epoch(const void *record) {
+    return snapshot_u32((const uint8_t *)record + TILE_RECORD_EPOCH);
+}
+
+static inline const char *tile_record_cells(const void *record) {
+    return (const char *)record + TILE_RECORD_CELLS;
+}
+
+/**
+ * Returns the aliens counted in one block of an overview record.
+ */
+static inline int overview_record_density(const void *record, int side, int row, int col) {
+    return ((const uint8_t *)record)[row * side + col];
+}
+
+static inline void overview_record_set_density(void *record, int side, int row, int col, int aliens) {
+    ((uint8_t *)record)[row * side + col] = (uint8_t)aliens;
+}
+
+static inline char overview_record_player_id(const void *record, int side, int slot) {
+    return (char)((const uint8_t *)record)[side * side + slot * OVERVIEW_PLAYER_SIZE + OVERVIEW_PLAYER_ID];
+}
+
+static inline int overview_record_player_score(const void *record, int side, int slot) {
+    const uint8_t *p = (const uint8_t *)record + side * side + slot * OVERVIEW_PLAYER_SIZE;
+    return (int)snapshot_u32(p + OVERVIEW_PLAYER_SCORE);
+}
+
+/**
+ * Writes the record of a player slot of an overview record.
+ */
+static inline void overview_record_set_player(void *record, int side, int slot, char id, int score) {
+    uint8_t *p = (uint8_t *)record + side * side + slot * OVERVIEW_PLAYER_SIZE;
+    p[OVERVIEW_PLAYER_ID] = (uint8_t)id;
+    snapshot_put32(p + OVERVIEW_PLAYER_SCORE, (uint32_t)score);
+}
+
+#endif
@@ -0,0 +1,185 @@
+#ifndef LEADERBOARD_QUERY_H
+#define LEADERBOARD_QUERY_H
+
+// Query API over the current ranking, served on a ROUTER socket by its own
+// thread so other tools do not have to follow the score stream and rank it
+// themselves. Requests are text, like the game server's:
+//
+//   "Leaderboard_top N"          the N best players
+//   "Leaderboard_rank ID"        the player ID, with their rank
+//   "Leaderboard_around R N"     the players ranked R - N to R + N
+//   "Leaderboard_windows"        every player's score windows
+//
+// Ranking replies are a Simple_message whose players carry their rank and
+// whose version is the version of the ranking answered from. The windows
+// reply is the last Score_windows exported.
+//
+// Queries are answered from an immutable RankedSnapshot. The ingesting
+// thread builds a new one at most once per update and swaps it in
+// atomically, so queries never wait for ingestion nor ingestion for queries.
+
+#include <zmq.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "../endpoints.h"
+#include "../points.pb.h"
+
+#define MSG_QUERY_TOP "Leaderboard_top"
+#define MSG_QUERY_RANK "Leaderboard_rank"
+#define MSG_QUERY_AROUND "Leaderboard_around"
+#define MSG_QUERY_WINDOWS "Leaderboard_windows"
+#define QUERY_MAX_PLAYERS 100  // Most players in one reply
+#define QUERY_POLL_MS 100      // How often the query thread checks for stop()
+
+// A ranking frozen at one version, highest score first
+struct RankedSnapshot {
+    uint32_t version = 0;
+    std::vector<std::pair<std::string, int>> ranking;
+    std::unordered_map<std::string, size_t> positions;  // Index in ranking by id
+
+    /**
+     * Appends the next player of the ranking.
+     */
+    void add(const std::string &id, int score) {
+        positions.emplace(id, ranking.size());
+        ranking.emplace_back(id, score);
+    }
+};
+
+class LeaderboardQuery {
+public:
+    explicit LeaderboardQuery(zmq::context_t &context) : socket(context, ZMQ_ROUTER) {}
+    LeaderboardQuery(const LeaderboardQuery &) = delete;
+    LeaderboardQuery &operator=(const LeaderboardQuery &) = delete;
+    ~LeaderboardQuery() { stop(); }
+
+    /**
+     * Binds the query socket and starts answering queries.
+     *
+     * @param endpoints Comma-separated list of endpoints to bind.
+     * @return true on success, false if an endpoint could not be bound.
+     */
+    bool start(const char *endpoints) {
+        if (attach_endpoints(socket.handle(), endpoints, 1) != 0) return false;
+        running = true;
+        worker = std::thread(&LeaderboardQuery::serve, this);
+        return true;
+    }
+
+    /**
+     * Stops answering queries and closes the socket.
+     */
+    void stop() {
+        running = false;
+        if (worker.joinable()) worker.join();
+        socket.close();
+    }
+
+    /**
+     * Makes a new ranking visible to queries.
+     *
+     * @param snapshot The ranking, which must not be modified afterwards.
+     */
+    void publish(std::shared_ptr<const RankedSnapshot> snapshot) { std::atomic_store(&current, std::move(snapshot)); }
+
+    /**
+     * Makes a new export of the score windows visible to queries.
+     *
+     * @param serialized The serialized Score_windows message.
+     */
+    void publish_windows(std::shared_ptr<const std::string> serialized) {
+        std::atomic_store(&windows, std::move(serialized));
+    }
+
+private:
+    zmq::socket_t socket;  // Only used by the worker once started
+    std::thread worker;
+    std::atomic<bool> running{false};
+    std::shared_ptr<const RankedSnapshot> current = std::make_shared<RankedSnapshot>();
+    std::shared_ptr<const std::string> windows = std::make_shared<std::string>();
+
+    /**
+     * Receives requests and replies until stop() is called.
+     *
+     * Every frame before the request is the ROUTER envelope and is sent
+     * back unchanged in front of the reply.
+     */
+    void serve() {
+        std::vector<zmq::pollitem_t> items = {{socket.handle(), 0, ZMQ_POLLIN, 0}};
+        std::string buffer;
+
+        while (running) {
+            zmq::poll(items, std::chrono::milliseconds(QUERY_POLL_MS));
+            if (!(items[0].revents & ZMQ_POLLIN)) continue;
+
+            std::vector<zmq::message_t> frames;
+            do {
+                frames.emplace_back();
+                if (!socket.recv(frames.back(), zmq::recv_flags::none)) break;
+            } while (frames.back().more());
+            if (frames.size() < 2) continue;  // No envelope to reply to
+
+            std::string request(static_cast<char *>(frames.back().data()), frames.back().size());
+            if (request == MSG_QUERY_WINDOWS) {
+                buffer = *std::atomic_load(&windows);
+            } else {
+                Simple_message reply;
+                answer(*std::atomic_load(&current), request, &reply);
+                reply.SerializeToString(&buffer);
+            }
+
+            for (size_t i = 0; i + 1 < frames.size(); i++) {
+                socket.send(frames[i], zmq::send_flags::sndmore);
+            }
+            socket.send(zmq::buffer(buffer), zmq::send_flags::none);
+        }
+    }
+
+    /**
+     * Answers one request from a snapshot.
+     *
+     * Unknown requests and players get a reply with no players.
+     */
+    static void answer(const RankedSnapshot &snapshot, const std::string &request, Simple_message *reply) {
+        char id[64];
+        int count = 0, rank = 0;
+        size_t first = 0, last = 0;  // Range of the ranking to reply with
+
+        if (sscanf(request.c_str(), MSG_QUERY_TOP " %d", &count) == 1 && count > 0) {
+            last = static_cast<size_t>(count);
+        } else if (sscanf(request.c_str(), MSG_QUERY_RANK " %63s", id) == 1) {
+            auto found = snapshot.positions.find(id);
+            if (found != snapshot.positions.end()) {
+                first = found->second;
+                last = first + 1;
+            }
+        } else if (sscanf(request.c_str(), MSG_QUERY_AROUND " %d %d", &rank, &count) == 2 && rank > 0 && count >= 0) {
+            size_t center = static_cast<size_t>(rank) - 1;
+            first = center > static_cast<size_t>(count) ? center - count : 0;
+            last = center + count + 1;
+        }
+
+        if (last > snapshot.ranking.size()) last = snapshot.ranking.size();
+        if (last > first + QUERY_MAX_PLAYERS) last = first + QUERY_MAX_PLAYERS;
+
+        reply->set_version(snapshot.version);
+        for (size_t i = first; i < last; i++) {
+            Player *player = reply->add_players();
+            player->set_id(snapshot.ranking[i].first);
+            player->set_score(snapshot.ranking[i].second);
+            player->set_rank(static_cast<int>(i + 1));
+        }
+    }
+};
+
+#endif
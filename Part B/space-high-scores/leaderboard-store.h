@@ -0,0 +1,364 @@
+#ifndef LEADERBOARD_STORE_H
+#define LEADERBOARD_STORE_H
+
+// Durable all-time leaderboard: the best score of every player ever seen.
+//
+// The store is two files. PATH.idx is a memory-mapped open-addressing hash
+// table of players, preceded by a header holding the current top scores, so
+// a top-N query at startup is a read of the first page. PATH.log is an
+// append-only log of score improvements, each record checksummed. An
+// improvement is appended to the log first and then applied to the index in
+// place; every LEADERBOARD_COMPACT_RECORDS records the index is flushed and
+// the log truncated.
+//
+// Applying a record keeps the maximum of the stored and logged scores, so
+// replaying the log on open is harmless whatever state a crash left the index
+// in, and a torn record at the end of the log is dropped. The index only
+// grows by building a new file and renaming it over the old one. Memory use
+// stays bounded however many players are stored: the index is paged in from
+// the file on demand and only the log tail is ever read into memory.
+
+#include <fcntl.h>     // for open, O_RDWR, O_CREAT
+#include <sys/mman.h>  // for mmap, msync, munmap
+#include <sys/stat.h>  // for fstat
+#include <unistd.h>    // for read, write, ftruncate, fdatasync, close
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+#define LEADERBOARD_MAGIC 0x58444c42         // "BLDX"
+#define LEADERBOARD_RECORD_MAGIC 0x474f4c42  // "BLOG"
+#define LEADERBOARD_VERSION 1
+#define LEADERBOARD_ID_SIZE 16               // Longest id is one less
+#define LEADERBOARD_TOP_MAX 100              // Scores kept in the index header
+#define LEADERBOARD_INITIAL_CAPACITY 1024    // Hash slots in a new index
+#define LEADERBOARD_COMPACT_RECORDS 4096     // Log records between compactions
+
+struct LeaderboardEntry {
+    char id[LEADERBOARD_ID_SIZE];  // NUL-padded, empty for a free slot
+    int32_t score;
+    uint32_t reserved;
+};
+
+struct LeaderboardHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t capacity;   // Hash slots following the header, a power of two
+    uint64_t count;      // Used slots
+    uint32_t top_count;
+    uint32_t reserved;
+    LeaderboardEntry top[LEADERBOARD_TOP_MAX];  // Highest score first
+};
+
+struct LeaderboardRecord {
+    uint32_t magic;
+    int32_t score;
+    char id[LEADERBOARD_ID_SIZE];
+    uint32_t checksum;  // FNV-1a of the fields above
+};
+
+class LeaderboardStore {
+public:
+    LeaderboardStore() = default;
+    LeaderboardStore(const LeaderboardStore &) = delete;
+    LeaderboardStore &operator=(const LeaderboardStore &) = delete;
+    ~LeaderboardStore() { close(); }
+
+    /**
+     * Opens the store, creating it if needed, and replays the log.
+     *
+     * @param path Path of the store, without the .idx and .log suffixes.
+     * @return true on success, false if a file could not be opened or mapped.
+     */
+    bool open(const std::string &path) {
+        index_path = path + ".idx";
+        log_fd = ::open((path + ".log").c_str(), O_RDWR | O_CREAT | O_APPEND, 0644);
+        if (log_fd == -1) return false;
+
+        index_fd = ::open(index_path.c_str(), O_RDWR | O_CREAT, 0644);
+        struct stat st;
+        if (index_fd == -1 || fstat(index_fd, &st) == -1) return false;
+        if (!map_index((size_t)st.st_size) || !valid_index()) {
+            // New or unusable index: start empty, the log refills what it can
+            unmap_index();
+            if (!create_index(LEADERBOARD_INITIAL_CAPACITY)) return false;
+        }
+        return replay_log();
+    }
+
+    /**
+     * Flushes the index and closes the store.
+     */
+    void close() {
+        if (header) msync(header, mapped_size, MS_SYNC);
+        unmap_index();
+        if (index_fd != -1) ::close(index_fd);
+        if (log_fd != -1) ::close(log_fd);
+        index_fd = -1;
+        log_fd = -1;
+    }
+
+    /**
+     * Records a player's score if it beats their best.
+     *
+     * The record is written to the log but not synced; call sync() once a
+     * batch of scores has been recorded.
+     *
+     * @param id Player id, at most LEADERBOARD_ID_SIZE - 1 bytes.
+     * @param score Current score of the player.
+     * @return 1 if the best score improved, 0 if not or the id is unusable,
+     *         -1 if the log could not be written.
+     */
+    int record(const std::string &id, int32_t score) {
+        if (id.empty() || id.size() >= LEADERBOARD_ID_SIZE) return 0;
+        const LeaderboardEntry *entry = find(id.c_str());
+        if (entry && entry->score >= score) return 0;
+
+        LeaderboardRecord rec = {};
+        rec.magic = LEADERBOARD_RECORD_MAGIC;
+        rec.score = score;
+        memcpy(rec.id, id.data(), id.size());
+        rec.checksum = checksum(&rec);
+        if (write(log_fd, &rec, sizeof(rec)) != (ssize_t)sizeof(rec)) return -1;
+        log_records++;
+
+        if (!apply(rec.id, score)) return -1;
+        if (log_records >= LEADERBOARD_COMPACT_RECORDS && !compact()) return -1;
+        return 1;
+    }
+
+    /**
+     * Makes the recorded scores durable.
+     *
+     * @return true on success.
+     */
+    bool sync() { return fdatasync(log_fd) == 0; }
+
+    /**
+     * Returns the best scores, highest first.
+     *
+     * @param n Number of scores wanted, at most LEADERBOARD_TOP_MAX.
+     * @return Up to n pairs of player id and score.
+     */
+    std::vector<std::pair<std::string, int32_t>> top(size_t n) const {
+        std::vector<std::pair<std::string, int32_t>> result;
+        for (size_t i = 0; i < n && i < header->top_count; i++) {
+            result.emplace_back(std::string(header->top[i].id, strnlen(header->top[i].id, LEADERBOARD_ID_SIZE)),
+                                header->top[i].score);
+        }
+        return result;
+    }
+
+    /**
+     * Returns the number of players stored.
+     */
+    uint64_t players() const { return header->count; }
+
+private:
+    std::string index_path;
+    int log_fd = -1;
+    int index_fd = -1;
+    LeaderboardHeader *header = nullptr;
+    LeaderboardEntry *slots = nullptr;
+    size_t mapped_size = 0;
+    uint64_t log_records = 0;  // Records in the log since the last compaction
+
+    static size_t index_size(uint64_t capacity) {
+        return sizeof(LeaderboardHeader) + capacity * sizeof(LeaderboardEntry);
+    }
+
+    static uint32_t fnv1a(const void *data, size_t size, uint32_t hash = 2166136261u) {
+        const unsigned char *bytes = static_cast<const unsigned char *>(data);
+        for (size_t i = 0; i < size; i++) hash = (hash ^ bytes[i]) * 16777619u;
+        return hash;
+    }
+
+    static uint32_t checksum(const LeaderboardRecord *rec) {
+        return fnv1a(rec, offsetof(LeaderboardRecord, checksum));
+    }
+
+    bool map_index(size_t size) {
+        if (size < sizeof(LeaderboardHeader)) return false;
+        void *mapping = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, index_fd, 0);
+        if (mapping == MAP_FAILED) return false;
+        header = static_cast<LeaderboardHeader *>(mapping);
+        slots = reinterpret_cast<LeaderboardEntry *>(header + 1);
+        mapped_size = size;
+        return true;
+    }
+
+    void unmap_index() {
+        if (header) munmap(header, mapped_size);
+        header = nullptr;
+        slots = nullptr;
+        mapped_size = 0;
+    }
+
+    bool valid_index() const {
+        uint64_t capacity = header->capacity;
+        return header->magic == LEADERBOARD_MAGIC && header->version == LEADERBOARD_VERSION &&
+               capacity > 0 && (capacity & (capacity - 1)) == 0 && index_size(capacity) == mapped_size &&
+               header->top_count <= LEADERBOARD_TOP_MAX;
+    }
+
+    /**
+     * Sizes an index file for an empty table and maps it.
+     *
+     * The magic is written last, so a crash leaves a file open() discards.
+     */
+    bool create_index(uint64_t capacity) {
+        size_t size = index_size(capacity);
+        if (ftruncate(index_fd, 0) == -1 || ftruncate(index_fd, (off_t)size) == -1 || !map_index(size)) {
+            return false;
+        }
+        header->version = LEADERBOARD_VERSION;
+        header->capacity = capacity;
+        header->magic = LEADERBOARD_MAGIC;
+        return true;
+    }
+
+    /**
+     * Applies the log to the index, dropping a torn record at its end.
+     */
+    bool replay_log() {
+        struct stat st;
+        if (fstat(log_fd, &st) == -1) return false;
+
+        LeaderboardRecord rec;
+        off_t offset = 0;
+        while (offset + (off_t)sizeof(rec) <= st.st_size &&
+               pread(log_fd, &rec, sizeof(rec), offset) == (ssize_t)sizeof(rec) &&
+               rec.magic == LEADERBOARD_RECORD_MAGIC && rec.checksum == checksum(&rec)) {
+            rec.id[LEADERBOARD_ID_SIZE - 1] = '\0';
+            if (rec.id[0] && !apply(rec.id, rec.score)) return false;
+            offset += sizeof(rec);
+        }
+        if (offset != st.st_size && ftruncate(log_fd, offset) == -1) return false;
+        log_records = (uint64_t)offset / sizeof(rec);
+        return true;
+    }
+
+    LeaderboardEntry *slot_for(const char *id) const {
+        char key[LEADERBOARD_ID_SIZE] = {};
+        memcpy(key, id, strnlen(id, LEADERBOARD_ID_SIZE - 1));
+        uint64_t mask = header->capacity - 1;
+        for (uint64_t i = fnv1a(key, sizeof(key)) & mask;; i = (i + 1) & mask) {
+            if (!slots[i].id[0] || memcmp(slots[i].id, key, sizeof(key)) == 0) return &slots[i];
+        }
+    }
+
+    const LeaderboardEntry *find(const char *id) const {
+        const LeaderboardEntry *entry = slot_for(id);
+        return entry->id[0] ? entry : nullptr;
+    }
+
+    /**
+     * Raises a player's best score in the index and the top scores.
+     */
+    bool apply(const char *id, int32_t score) {
+        LeaderboardEntry *entry = slot_for(id);
+        if (!entry->id[0]) {
+            if ((header->count + 1) * 10 > header->capacity * 7) {
+                if (!grow()) return false;
+                entry = slot_for(id);
+            }
+            memcpy(entry->id, id, strnlen(id, LEADERBOARD_ID_SIZE - 1));
+            entry->score = score;
+            header->count++;
+        } else if (entry->score < score) {
+            entry->score = score;
+        }
+        update_top(*entry);
+        return true;
+    }
+
+    /**
+     * Keeps the header's top scores in order after a best score rose.
+     */
+    void update_top(const LeaderboardEntry &entry) {
+        uint32_t i = 0;
+        while (i < header->top_count && memcmp(header->top[i].id, entry.id, LEADERBOARD_ID_SIZE) != 0) i++;
+
+        if (i == header->top_count) {
+            if (header->top_count == LEADERBOARD_TOP_MAX) {
+                if (entry.score <= header->top[LEADERBOARD_TOP_MAX - 1].score) return;
+                i = LEADERBOARD_TOP_MAX - 1;  // Replaces the lowest score
+            } else {
+                header->top_count++;
+            }
+        }
+        header->top[i] = entry;
+        for (; i > 0 && header->top[i - 1].score < header->top[i].score; i--) {
+            LeaderboardEntry swap = header->top[i - 1];
+            header->top[i - 1] = header->top[i];
+            header->top[i] = swap;
+        }
+    }
+
+    /**
+     * Rehashes the index into a table twice the size.
+     *
+     * The new table is written to a separate file and renamed over the old
+     * one, so a crash leaves either index intact.
+     */
+    bool grow() {
+        std::string path = index_path + ".tmp";
+        int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (fd == -1) return false;
+
+        uint64_t capacity = header->capacity * 2;
+        size_t size = index_size(capacity);
+        void *mapping = MAP_FAILED;
+        if (ftruncate(fd, (off_t)size) == 0) {
+            mapping = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        }
+        if (mapping == MAP_FAILED) {
+            ::close(fd);
+            unlink(path.c_str());
+            return false;
+        }
+
+        LeaderboardHeader *grown = static_cast<LeaderboardHeader *>(mapping);
+        LeaderboardEntry *grown_slots = reinterpret_cast<LeaderboardEntry *>(grown + 1);
+        memcpy(grown, header, sizeof(LeaderboardHeader));
+        grown->capacity = capacity;
+        grown->count = 0;
+        for (uint64_t i = 0; i < header->capacity; i++) {
+            if (!slots[i].id[0]) continue;
+            uint64_t j = fnv1a(slots[i].id, LEADERBOARD_ID_SIZE) & (capacity - 1);
+            while (grown_slots[j].id[0]) j = (j + 1) & (capacity - 1);
+            grown_slots[j] = slots[i];
+            grown->count++;
+        }
+
+        if (msync(mapping, size, MS_SYNC) == -1 || rename(path.c_str(), index_path.c_str()) == -1) {
+            munmap(mapping, size);
+            ::close(fd);
+            unlink(path.c_str());
+            return false;
+        }
+        unmap_index();
+        ::close(index_fd);
+        index_fd = fd;
+        header = grown;
+        slots = grown_slots;
+        mapped_size = size;
+        return true;
+    }
+
+    /**
+     * Flushes the index and empties the log it now covers.
+     */
+    bool compact() {
+        if (msync(header, mapped_size, MS_SYNC) == -1 || ftruncate(log_fd, 0) == -1) return false;
+        log_records = 0;
+        return true;
+    }
+};
+
+#endif
@@ -0,0 +1,166 @@
+#ifndef SCORE_AGGREGATOR_H
+#define SCORE_AGGREGATOR_H
+
+// Global ranking of the players of several game servers.
+//
+// Each server's MSG_SCORES stream is applied to its own score table, and
+// every change is mirrored into an order-statistics tree holding the scores
+// of all servers, so an update costs O(log n) and the top K is read off the
+// front of the tree. Players are keyed by "SOURCE/ID", the index of their
+// server in the configured list followed by their id on that server.
+
+#include <ext/pb_ds/assoc_container.hpp>  // for __gnu_pbds::tree
+#include <ext/pb_ds/tree_policy.hpp>      // for tree_order_statistics_node_update
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "../points.pb.h"
+#include "leaderboard-query.h"
+
+class ScoreAggregator {
+public:
+    /**
+     * @param count Number of game servers aggregated.
+     */
+    explicit ScoreAggregator(size_t count) : sources(count) {}
+
+    /**
+     * Applies a Simple_message received from a game server.
+     *
+     * Full messages replace the server's scores. Incremental ones are applied
+     * on top of them as long as no version was missed; after a gap they are
+     * ignored until the next full message.
+     *
+     * @param source Index of the server.
+     * @param msg The scores message.
+     * @return true if the global ranking changed.
+     */
+    bool apply(size_t source, const Simple_message &msg) {
+        Source &src = sources[source];
+        bool changed = false;
+
+        if (msg.incremental()) {
+            if (!src.synced || msg.version() != src.version + 1) {
+                src.synced = false;
+                return false;
+            }
+            for (int i = 0; i < msg.left_size(); i++) {
+                changed |= remove(source, msg.left(i));
+            }
+        } else {
+            // Players missing from a full message have left
+            std::vector<std::string> left;
+            for (const auto &entry : src.scores) left.push_back(entry.first);
+            for (int i = 0; i < msg.players_size(); i++) {
+                for (size_t j = 0; j < left.size(); j++) {
+                    if (left[j] == msg.players(i).id()) {
+                        left[j] = left.back();
+                        left.pop_back();
+                        break;
+                    }
+                }
+            }
+            for (const auto &id : left) changed |= remove(source, id);
+            src.synced = true;
+        }
+        src.version = msg.version();
+
+        for (int i = 0; i < msg.players_size(); i++) {
+            const Player &player = msg.players(i);
+            if (!player.id().empty()) changed |= set(source, player.id(), player.score());
+        }
+        return changed;
+    }
+
+    /**
+     * Removes every player of a game server, after it terminated.
+     *
+     * @param source Index of the server.
+     * @return true if the global ranking changed.
+     */
+    bool drop(size_t source) {
+        Source &src = sources[source];
+        for (const auto &entry : src.scores) ranking.erase(Ranked(entry.second, key(source, entry.first)));
+        bool changed = !src.scores.empty();
+        src = Source();
+        return changed;
+    }
+
+    /**
+     * Fills a Simple_message with the best scores of all servers.
+     *
+     * @param count Number of players wanted.
+     * @param msg Message whose players are replaced, highest score first.
+     */
+    void top(size_t count, Simple_message *msg) const {
+        msg->clear_players();
+        for (auto it = ranking.begin(); it != ranking.end() && count > 0; ++it, --count) {
+            Player *player = msg->add_players();
+            player->set_id(it->second);
+            player->set_score(it->first);
+        }
+    }
+
+    /**
+     * Copies the whole ranking into a snapshot for the query service.
+     *
+     * @param version Version stamped on the snapshot.
+     * @return The ranking, highest score first.
+     */
+    std::shared_ptr<RankedSnapshot> snapshot(uint32_t version) const {
+        auto ranked = std::make_shared<RankedSnapshot>();
+        ranked->version = version;
+        ranked->ranking.reserve(ranking.size());
+        for (const auto &entry : ranking) ranked->add(entry.second, entry.first);
+        return ranked;
+    }
+
+    /**
+     * Returns the number of players ranked.
+     */
+    size_t size() const { return ranking.size(); }
+
+private:
+    typedef std::pair<int, std::string> Ranked;  // Score, then "SOURCE/ID"
+    typedef __gnu_pbds::tree<Ranked, __gnu_pbds::null_type, std::greater<Ranked>, __gnu_pbds::rb_tree_tag,
+                             __gnu_pbds::tree_order_statistics_node_update>
+        Ranking;
+
+    struct Source {
+        uint32_t version = 0;
+        bool synced = false;
+        std::unordered_map<std::string, int> scores;  // By player id on the server
+    };
+
+    std::vector<Source> sources;
+    Ranking ranking;  // Highest score first
+
+    static std::string key(size_t source, const std::string &id) { return std::to_string(source) + "/" + id; }
+
+    bool set(size_t source, const std::string &id, int score) {
+        auto inserted = sources[source].scores.emplace(id, score);
+        if (!inserted.second) {
+            if (inserted.first->second == score) return false;
+            ranking.erase(Ranked(inserted.first->second, key(source, id)));
+            inserted.first->second = score;
+        }
+        ranking.insert(Ranked(score, key(source, id)));
+        return true;
+    }
+
+    bool remove(size_t source, const std::string &id) {
+        auto found = sources[source].scores.find(id);
+        if (found == sources[source].scores.end()) return false;
+        ranking.erase(Ranked(found->second, key(source, id)));
+        sources[source].scores.erase(found);
+        return true;
+    }
+};
+
+#endif
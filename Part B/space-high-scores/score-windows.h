@@ -0,0 +1,182 @@
+#ifndef SCORE_WINDOWS_H
+#define SCORE_WINDOWS_H
+
+// Per-player activity over sliding windows: points, kills, zaps and the
+// longest run of zaps that hit, over the last minute, the last ten minutes
+// and the whole session.
+//
+// Each windowed series is a ring of WINDOW_BUCKETS buckets, one second wide
+// for the minute and ten seconds wide for ten minutes. A bucket remembers
+// which interval it holds and is cleared when the ring comes back to it, so
+// an update touches one bucket per series and nothing is ever allocated:
+// every player has a fixed slot in a table of WINDOW_PLAYERS, and the
+// longest idle one is reused when a new player shows up with the table full.
+//
+// Points come from the Player records of the score stream, zaps and kills
+// from the ZAP events of the game event stream.
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include "../points.pb.h"
+
+#define WINDOW_BUCKETS 60
+#define WINDOW_SERIES 2    // Windowed series, besides the session totals
+#define WINDOW_PLAYERS 64  // Players tracked at once
+#define WINDOW_ID_SIZE 16  // Longest id is one less
+
+static const int window_bucket_seconds[WINDOW_SERIES] = {1, 10};  // 1 and 10 minute windows
+
+struct WindowBucket {
+    int64_t interval;  // Start time divided by the bucket width
+    int32_t points;
+    int32_t kills;
+    int32_t zaps;
+    int32_t best_streak;
+};
+
+struct PlayerWindows {
+    char id[WINDOW_ID_SIZE];  // Empty for a free slot
+    int64_t last_seen;
+    int32_t score;            // Last score seen, to turn totals into points
+    int32_t streak;           // Zaps in a row that hit
+    WindowBucket session;
+    WindowBucket series[WINDOW_SERIES][WINDOW_BUCKETS];
+};
+
+class ScoreWindows {
+public:
+    ScoreWindows() { memset(players, 0, sizeof(players)); }
+
+    /**
+     * Records a player's score from the score stream.
+     *
+     * The first score of a player only sets the baseline. A lower score
+     * than the last one means the id was given to a new player, whose
+     * series start over.
+     *
+     * @param id Player id.
+     * @param score Current score of the player.
+     * @param now Current Unix time.
+     */
+    void score(const std::string &id, int32_t score, int64_t now) {
+        bool found;
+        PlayerWindows *player = lookup(id, now, &found);
+        if (!player) return;
+        if (found && score < player->score) reset(player, now);
+        if (found && score > player->score) add(player, now, score - player->score, 0, 0);
+        player->score = score;
+    }
+
+    /**
+     * Records a zap from the game event stream.
+     *
+     * @param id Id of the astronaut who fired.
+     * @param kills Aliens hit by the shot.
+     * @param now Current Unix time.
+     */
+    void zap(const std::string &id, int32_t kills, int64_t now) {
+        bool found;
+        PlayerWindows *player = lookup(id, now, &found);
+        if (!player) return;
+        player->streak = kills > 0 ? player->streak + 1 : 0;
+        add(player, now, 0, kills, 1);
+    }
+
+    /**
+     * Exports every player's windows.
+     *
+     * @param now Time the windows end at.
+     * @param out Message whose windows are replaced, three per player.
+     */
+    void export_to(int64_t now, Score_windows *out) const {
+        out->Clear();
+        out->set_time(static_cast<uint64_t>(now));
+        for (const PlayerWindows &player : players) {
+            if (!player.id[0]) continue;
+            for (int s = 0; s < WINDOW_SERIES; s++) {
+                WindowBucket total = {};
+                int64_t current = now / window_bucket_seconds[s];
+                for (const WindowBucket &bucket : player.series[s]) {
+                    if (bucket.interval <= current - WINDOW_BUCKETS || bucket.interval > current) continue;
+                    merge(&total, bucket);
+                }
+                append(out, player.id, window_bucket_seconds[s] * WINDOW_BUCKETS, total);
+            }
+            append(out, player.id, 0, player.session);
+        }
+    }
+
+private:
+    PlayerWindows players[WINDOW_PLAYERS];
+
+    /**
+     * Finds a player's slot, taking a free or the longest idle one if new.
+     *
+     * @param found Set to whether the player already had a slot.
+     * @return The slot, or NULL if the id is unusable.
+     */
+    PlayerWindows *lookup(const std::string &id, int64_t now, bool *found) {
+        *found = false;
+        if (id.empty() || id.size() >= WINDOW_ID_SIZE) return nullptr;
+
+        PlayerWindows *oldest = &players[0];
+        for (PlayerWindows &player : players) {
+            if (strcmp(player.id, id.c_str()) == 0) {
+                player.last_seen = now;
+                *found = true;
+                return &player;
+            }
+            if (!player.id[0] || (oldest->id[0] && player.last_seen < oldest->last_seen)) oldest = &player;
+        }
+
+        reset(oldest, now);
+        memcpy(oldest->id, id.c_str(), id.size() + 1);
+        return oldest;
+    }
+
+    static void reset(PlayerWindows *player, int64_t now) {
+        char id[WINDOW_ID_SIZE];
+        memcpy(id, player->id, sizeof(id));
+        memset(player, 0, sizeof(*player));
+        memcpy(player->id, id, sizeof(id));
+        player->last_seen = now;
+        player->session.interval = now;
+    }
+
+    static void add(PlayerWindows *player, int64_t now, int32_t points, int32_t kills, int32_t zaps) {
+        WindowBucket *session = &player->session;
+        for (int s = 0; s <= WINDOW_SERIES; s++) {
+            WindowBucket *bucket = session;
+            if (s < WINDOW_SERIES) {
+                int64_t interval = now / window_bucket_seconds[s];
+                bucket = &player->series[s][interval % WINDOW_BUCKETS];
+                if (bucket->interval != interval) *bucket = WindowBucket{interval, 0, 0, 0, 0};
+            }
+            bucket->points += points;
+            bucket->kills += kills;
+            bucket->zaps += zaps;
+            if (player->streak > bucket->best_streak) bucket->best_streak = player->streak;
+        }
+    }
+
+    static void merge(WindowBucket *total, const WindowBucket &bucket) {
+        total->points += bucket.points;
+        total->kills += bucket.kills;
+        total->zaps += bucket.zaps;
+        if (bucket.best_streak > total->best_streak) total->best_streak = bucket.best_streak;
+    }
+
+    static void append(Score_windows *out, const char *id, int seconds, const WindowBucket &total) {
+        Score_window *window = out->add_windows();
+        window->set_id(id);
+        window->set_seconds(static_cast<uint32_t>(seconds));
+        window->set_points(total.points);
+        window->set_kills(total.kills);
+        window->set_zaps(total.zaps);
+        window->set_best_streak(total.best_streak);
+    }
+};
+
+#endif
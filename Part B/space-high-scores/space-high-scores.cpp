@@ -1,13 +1,280 @@
 #include <zmq.hpp>
 #include <string>
+#include <chrono>
+#include <ctime>
+#include <algorithm>
 #include <iostream>
+#include <map>
+#include <memory>
+#include <vector>
 #include <unistd.h>
 #include <cstdlib>
 #include "../points.pb.h"
+#include "../endpoints.h"
+#include "../shared-state.h"
+#include "../snapshot.h"
+#include "leaderboard-query.h"
+#include "leaderboard-store.h"
+#include "score-aggregator.h"
+#include "score-windows.h"
 #include "stdlib.h"
 
-#define PUBLISHER_ADDRESS "tcp://127.0.0.1:5554"
+#define DEFAULT_PUBLISHER_ADDRESS "tcp://127.0.0.1:5554"
 #define MSG_SERVER "Server_terminate"
+#define MSG_SCORES "MSG_SCORES"
+#define MSG_EVENT "Game_event"
+#define LEADERBOARD_PATH "space-high-scores"  // Store files, in the working directory
+#define LEADERBOARD_SHOWN 10                  // All-time scores shown under the current ones
+#define DEFAULT_AGGREGATE_ADDRESS "tcp://127.0.0.1:5574"
+#define DEFAULT_QUERY_ADDRESS "tcp://127.0.0.1:5579"  // Leaderboard queries, with --query
+#define WINDOW_EXPORT_MS 1000                  // Minimum time between score window exports
+#define MSG_GLOBAL_SCORES "MSG_GLOBAL_SCORES"  // Merged ranking published by --aggregate
+#define AGGREGATE_TOP_K 100                    // Players in the merged ranking
+#define AGGREGATE_PUBLISH_MS 100               // Minimum time between merged rankings
+#define RANKING_PUBLISH_MS 100                 // Minimum time between rankings rebuilt for queries
+
+/**
+ * Prints the best scores of all time.
+ *
+ * @param store The leaderboard store.
+ * @param count Number of scores to print.
+ */
+void print_leaderboard(const LeaderboardStore &store, size_t count) {
+    std::cout << "All-time High Scores (" << store.players() << " players):" << std::endl;
+    for (const auto &entry : store.top(count)) {
+        std::cout << "Player ID: " << entry.first << ", Score: " << entry.second << std::endl;
+    }
+}
+
+/**
+ * Ranks the current scores and makes the ranking visible to queries.
+ *
+ * Does nothing if the last ranking is less than RANKING_PUBLISH_MS old, so
+ * callers can try after every message and again once it has gone quiet.
+ *
+ * @param queries The query service.
+ * @param scores Current score of every active player.
+ * @return true if the ranking was rebuilt, false if it is still pending.
+ */
+bool publish_ranking(LeaderboardQuery &queries, const std::map<std::string, int> &scores) {
+    static uint32_t version = 0;
+    static std::chrono::steady_clock::time_point published;
+    auto now = std::chrono::steady_clock::now();
+    if (now - published < std::chrono::milliseconds(RANKING_PUBLISH_MS)) return false;
+    published = now;
+
+    std::vector<std::pair<std::string, int>> ranked(scores.begin(), scores.end());
+    std::stable_sort(ranked.begin(), ranked.end(),
+                     [](const std::pair<std::string, int> &a, const std::pair<std::string, int> &b) {
+                         return a.second > b.second;
+                     });
+
+    auto snapshot = std::make_shared<RankedSnapshot>();
+    snapshot->version = ++version;
+    for (const auto &entry : ranked) snapshot->add(entry.first, entry.second);
+    queries.publish(snapshot);
+    return true;
+}
+
+/**
+ * Exports the score windows to the query service.
+ *
+ * Does nothing if the last export is less than WINDOW_EXPORT_MS old, so
+ * callers can try after every message.
+ *
+ * @param queries The query service.
+ * @param windows The score windows.
+ */
+void export_windows(LeaderboardQuery &queries, const ScoreWindows &windows) {
+    static std::chrono::steady_clock::time_point exported;
+    static Score_windows msg;
+    auto now = std::chrono::steady_clock::now();
+    if (now - exported < std::chrono::milliseconds(WINDOW_EXPORT_MS)) return;
+    exported = now;
+
+    windows.export_to(time(NULL), &msg);
+    queries.publish_windows(std::make_shared<const std::string>(msg.SerializeAsString()));
+}
+
+/**
+ * Records the current scores in the leaderboard store and displays them.
+ *
+ * Scores that beat a player's best are synced to disk before returning,
+ * the ranking answered by queries is replaced at most every
+ * RANKING_PUBLISH_MS, and the scores are added to the players' score
+ * windows.
+ *
+ * @param store The leaderboard store.
+ * @param queries The query service.
+ * @param windows The score windows.
+ * @param scores Current score of every active player.
+ * @return true if the ranking was rebuilt, false if it is still pending.
+ */
+bool show_scores(LeaderboardStore &store, LeaderboardQuery &queries, ScoreWindows &windows,
+                 const std::map<std::string, int> &scores) {
+    bool ranked = publish_ranking(queries, scores);
+    int64_t now = time(NULL);
+    for (const auto &entry : scores) windows.score(entry.first, entry.second, now);
+    export_windows(queries, windows);
+
+    bool improved = false, failed = false;
+    for (const auto &entry : scores) {
+        int result = store.record(entry.first, entry.second);
+        improved |= result > 0;
+        failed |= result < 0;
+    }
+    if (failed || (improved && !store.sync())) {
+        std::cerr << "Failed to write the leaderboard store." << std::endl;
+    }
+
+    std::cout << "\033[2J\033[H";
+    std::cout << "High Scores:" << std::endl;
+    for (const auto &entry : scores) {
+        std::cout << "Player ID: " << entry.first << ", Score: " << entry.second << std::endl;
+    }
+    std::cout << std::endl;
+    print_leaderboard(store, LEADERBOARD_SHOWN);
+    return ranked;
+}
+
+/**
+ * Displays the high scores published in shared memory by a local game server.
+ *
+ * Scores are read from the seqlock-protected segment, so no message is
+ * received or parsed; the reader sleeps on the segment's futex until the
+ * server publishes a new snapshot, then reads the scores in place with the
+ * snapshot.h accessors. A ranking held back by RANKING_PUBLISH_MS is
+ * rebuilt with the next snapshot, at the latest when the aliens next
+ * move. Returns when the server terminates.
+ *
+ * @param store The leaderboard store the scores are recorded in.
+ * @param queries The query service answering from the scores.
+ * @param windows The score windows fed with the scores.
+ * @return 0 on success, 1 if the segment could not be mapped.
+ */
+int run_shared_memory(LeaderboardStore &store, LeaderboardQuery &queries, ScoreWindows &windows) {
+    SharedState *shared = shared_state_map(0);
+    if (!shared) {
+        std::cerr << "Failed to map shared memory state." << std::endl;
+        return 1;
+    }
+
+    uint32_t seq = 0;
+    unsigned char snapshot[SHM_STATE_MAX];
+    while (shared_state_read(shared, &seq, snapshot, sizeof(snapshot)) == 1) {
+        if (snapshot_check(snapshot, sizeof(snapshot), 0) != 0) {
+            std::cerr << "Unsupported snapshot version." << std::endl;
+            break;
+        }
+
+        std::map<std::string, int> scores;
+        for (int i = 0; i < snapshot_slots(snapshot); i++) {
+            if (snapshot_player_in_use(snapshot, i)) {
+                scores[std::string(1, snapshot_player_id(snapshot, i))] = snapshot_player_score(snapshot, i);
+            }
+        }
+        show_scores(store, queries, windows, scores);
+    }
+
+    shared_state_unmap(shared, 0);
+    return 0;
+}
+
+/**
+ * Merges the scores of several game servers into one global ranking.
+ *
+ * One subscriber is connected to each publisher, so players are told apart
+ * by server. Every MSG_SCORES message updates the ScoreAggregator, and the
+ * AGGREGATE_TOP_K best players of all servers are republished on
+ * MSG_GLOBAL_SCORES at most every AGGREGATE_PUBLISH_MS, however many
+ * updates arrive in between, and the query service's ranking is rebuilt
+ * at the same rate. A terminated server's players are dropped. Runs until
+ * interrupted.
+ *
+ * @param context The ZeroMQ context.
+ * @param sources Comma-separated list of game server publisher endpoints.
+ * @param queries The query service answering from the merged ranking.
+ * @return 1 if the ranking could not be published.
+ */
+int run_aggregator(zmq::context_t &context, const std::string &sources, LeaderboardQuery &queries) {
+    std::vector<zmq::socket_t> subscribers;
+    for (size_t start = 0; start <= sources.size();) {
+        size_t comma = sources.find(',', start);
+        if (comma == std::string::npos) comma = sources.size();
+        if (comma > start) {
+            subscribers.emplace_back(context, ZMQ_SUB);
+            subscribers.back().connect(sources.substr(start, comma - start));
+            subscribers.back().set(zmq::sockopt::subscribe, MSG_SERVER);
+            subscribers.back().set(zmq::sockopt::subscribe, MSG_SCORES);
+        }
+        start = comma + 1;
+    }
+
+    zmq::socket_t publisher(context, ZMQ_PUB);
+    if (attach_endpoints(publisher.handle(), endpoint(ENV_AGGREGATE_ADDRESS, DEFAULT_AGGREGATE_ADDRESS), 1) != 0) {
+        std::cerr << "Failed to bind the aggregate publisher." << std::endl;
+        return 1;
+    }
+
+    std::vector<zmq::pollitem_t> items;
+    for (auto &subscriber : subscribers) items.push_back({subscriber.handle(), 0, ZMQ_POLLIN, 0});
+
+    ScoreAggregator aggregator(subscribers.size());
+    Simple_message ranking;
+    std::string buffer;
+    bool dirty = false;
+    auto published = std::chrono::steady_clock::now();
+
+    while (true) {
+        auto wait = std::chrono::milliseconds(-1);
+        if (dirty) {
+            auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - published);
+            wait = std::max(std::chrono::milliseconds(0), std::chrono::milliseconds(AGGREGATE_PUBLISH_MS) - elapsed);
+        }
+        zmq::poll(items, wait);
+
+        for (size_t i = 0; i < items.size(); i++) {
+            if (!(items[i].revents & ZMQ_POLLIN)) continue;
+
+            // Drain everything queued, the ranking is only published once
+            zmq::message_t topic_msg, request;
+            while (subscribers[i].recv(topic_msg, zmq::recv_flags::dontwait)) {
+                std::string topic(static_cast<char *>(topic_msg.data()), topic_msg.size());
+                if (topic == MSG_SERVER) {
+                    dirty |= aggregator.drop(i);
+                    continue;
+                }
+                if (!topic_msg.more() || !subscribers[i].recv(request, zmq::recv_flags::none)) continue;
+
+                Simple_message msg;
+                if (!msg.ParseFromArray(request.data(), request.size())) {
+                    std::cerr << "Failed to parse message." << std::endl;
+                    continue;
+                }
+                dirty |= aggregator.apply(i, msg);
+            }
+        }
+
+        if (!dirty || std::chrono::steady_clock::now() - published < std::chrono::milliseconds(AGGREGATE_PUBLISH_MS)) {
+            continue;
+        }
+        aggregator.top(AGGREGATE_TOP_K, &ranking);
+        ranking.set_version(ranking.version() + 1);
+        queries.publish(aggregator.snapshot(ranking.version()));
+        ranking.SerializeToString(&buffer);
+        publisher.send(zmq::buffer(std::string(MSG_GLOBAL_SCORES)), zmq::send_flags::sndmore);
+        publisher.send(zmq::buffer(buffer), zmq::send_flags::none);
+        published = std::chrono::steady_clock::now();
+        dirty = false;
+
+        std::cout << "\033[2J\033[H";
+        std::cout << "Global High Scores (" << aggregator.size() << " players):" << std::endl;
+        for (int i = 0; i < ranking.players_size() && i < LEADERBOARD_SHOWN; i++) {
+            std::cout << "Player ID: " << ranking.players(i).id() << ", Score: " << ranking.players(i).score()
+                      << std::endl;
+        }
+    }
+}
 
 /**
  * Main function that connects to a ZMQ publisher to receive and display high scores.
@@ -19,25 +286,87 @@
  * until a specific termination message is received.
  *
  * The function handles errors in receiving and parsing messages, ensuring robust
- * communication with the publisher.
+ * communication with the publisher. Passing --shm reads the scores from the
+ * shared memory segment of a game server on the same host instead.
+ *
+ * Every score is also recorded in a durable all-time leaderboard, stored in
+ * LEADERBOARD_PATH or the path given with --store, which is shown as soon as
+ * the program starts. --top N prints the N best scores of all time and exits.
+ *
+ * --aggregate ENDPOINTS merges the scores of several game servers instead;
+ * see run_aggregator. With --query, the ranking is also served to other
+ * tools on the query endpoint; see leaderboard-query.h. Points, kills,
+ * zaps and streaks per player over sliding windows are exported there
+ * too; see score-windows.h.
  */
-int main() {
+int main(int argc, char *argv[]) {
+    std::string store_path = LEADERBOARD_PATH;
+    std::string aggregate_sources;
+    bool shared_memory = false, query = false;
+    int top = 0;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--shm") shared_memory = true;
+        if (arg == "--store" && i + 1 < argc) store_path = argv[++i];
+        if (arg == "--top" && i + 1 < argc) top = atoi(argv[++i]);
+        if (arg == "--aggregate" && i + 1 < argc) aggregate_sources = argv[++i];
+        if (arg == "--query") query = true;
+    }
+
     zmq::context_t context(1);
+    LeaderboardQuery queries(context);
+    ScoreWindows windows;
+    if (query && !queries.start(endpoint(ENV_QUERY_ADDRESS, DEFAULT_QUERY_ADDRESS))) {
+        std::cerr << "Failed to bind the leaderboard query socket." << std::endl;
+        return 1;
+    }
+    if (!aggregate_sources.empty()) {
+        return run_aggregator(context, aggregate_sources, queries);
+    }
+
+    LeaderboardStore store;
+    if (!store.open(store_path)) {
+        std::cerr << "Failed to open the leaderboard store " << store_path << "." << std::endl;
+        return 1;
+    }
+    if (top > 0) {
+        print_leaderboard(store, top);
+        return 0;
+    }
+    print_leaderboard(store, LEADERBOARD_SHOWN);
+    if (shared_memory) {
+        return run_shared_memory(store, queries, windows);
+    }
+
     zmq::socket_t socket(context, ZMQ_SUB);
-    socket.connect(PUBLISHER_ADDRESS);
+    socket.connect(endpoint(ENV_PUBLISHER_ADDRESS, DEFAULT_PUBLISHER_ADDRESS));
 
     // Subscribe to the "highscores" topic
     socket.set(zmq::sockopt::subscribe, MSG_SERVER);
-    socket.set(zmq::sockopt::subscribe, "MSG_SCORES");
-    
+    socket.set(zmq::sockopt::subscribe, MSG_SCORES);
+    socket.set(zmq::sockopt::subscribe, MSG_EVENT);
+
+    // Wake up regularly so the windows are exported and a ranking held back
+    // by RANKING_PUBLISH_MS is rebuilt while nothing happens
+    socket.set(zmq::sockopt::rcvtimeo, RANKING_PUBLISH_MS);
+
+    // Scores are only published when they change; incremental messages are
+    // applied on top of the last full one as long as no version was missed
+    std::map<std::string, int> scores;
+    uint32_t version = 0;
+    bool synced = false, ranked = true;
 
+    // Reused for every message, parsing into them keeps their allocations
+    Simple_message msg;
+    Game_event event;
 
     while (true) {
         // Receive the topic
         zmq::message_t topic_msg;
         auto topic_recv_result = socket.recv(topic_msg, zmq::recv_flags::none);
         if (!topic_recv_result) {
-            std::cerr << "Failed to receive topic." << std::endl;
+            if (!ranked) ranked = publish_ranking(queries, scores);
+            export_windows(queries, windows);
             continue;
         }
 
@@ -54,24 +383,43 @@ int main() {
             continue;
         }
 
+        if (topic == MSG_EVENT) {
+            if (event.ParseFromArray(request.data(), request.size()) && event.type() == Game_event::ZAP) {
+                windows.zap(event.astronaut(), event.value(), time(NULL));
+            }
+            continue;
+        }
+
         // Deserialize the received protobuf message
-        Simple_message msg;
         if (!msg.ParseFromArray(request.data(), request.size())) {
             std::cerr << "Failed to parse message." << std::endl;
             continue;
         }
 
-        std::cout << "\033[2J\033[H";
-        std::cout << "High Scores:" << std::endl;
+        if (msg.incremental()) {
+            if (!synced || msg.version() != version + 1) {
+                synced = false;  // Missed an update, wait for the next full message
+                continue;
+            }
+            for (int i = 0; i < msg.left_size(); i++) {
+                scores.erase(msg.left(i));
+            }
+        } else {
+            scores.clear();
+            synced = true;
+        }
+        version = msg.version();
+
         for (int i = 0; i < msg.players_size(); i++) {
             const Player &player = msg.players(i);
-            if (player.id().empty()) {
-                continue;
+            if (!player.id().empty()) {
+                scores[player.id()] = player.score();
             }
-            std::cout << "Player ID: " << player.id() << ", Score: " << player.score() << std::endl;
         }
+        ranked = show_scores(store, queries, windows, scores);
     }
 
+    queries.stop();
     socket.close();
     context.close();
 
@@ -0,0 +1,31 @@
+#ifndef COMMON_H
+#define COMMON_H
+
+#include <stdint.h>  // for uint64_t
+#include <stdio.h>   // for printf, perror
+#include <string.h>  // for strlen, memcmp, memcpy
+#include <time.h>    // for clock_gettime
+#include <zmq.h>     // for zmq_poll, zmq_msg_recv, zmq_msg_send, zmq_socket
+#include "../endpoints.h"
+
+#define DEFAULT_PUBLISHER_ADDRESS "tcp://127.0.0.1:5554" // Upstream: game server or another relay
+#define DEFAULT_RELAY_ADDRESS "tcp://*:5584"             // Downstream subscribers connect here
+
+#define ENV_RELAY_UPSTREAM "SPACE_RELAY_UPSTREAM"
+#define ENV_RELAY_ADDRESS "SPACE_RELAY_ADDRESS"
+
+#define MSG_SERVER "Server_terminate"
+#define MSG_CLOCK "Server_clock"
+
+#define RELAY_REPORT_SECONDS 5  // Interval between throughput and lag reports
+
+// Counters reported every RELAY_REPORT_SECONDS
+typedef struct {
+    uint64_t messages;
+    uint64_t bytes;
+    uint64_t subscriptions;
+    double lag_ms;      // Lag of the last clock message
+    double max_lag_ms;  // Largest lag seen in the interval
+} RelayStats;
+
+#endif
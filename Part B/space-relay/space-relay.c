@@ -0,0 +1,184 @@
+#include "common.h"
+
+/**
+ * Returns the current wall-clock time in microseconds.
+ *
+ * @return Microseconds since the epoch.
+ */
+uint64_t now_us() {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/**
+ * Forwards one multipart message from the upstream XSUB socket downstream.
+ *
+ * Frames are moved without copying. When the message is a clock message
+ * published by the game server, the relay's lag behind the server is
+ * recorded.
+ *
+ * @param upstream XSUB socket connected to the game server or parent relay.
+ * @param downstream XPUB socket subscribers connect to.
+ * @param stats Pointer to the RelayStats to be updated.
+ * @return 1 if the server terminated, 0 otherwise, -1 on error.
+ */
+int forward_message(void *upstream, void *downstream, RelayStats *stats) {
+    int part = 0, is_clock = 0, terminated = 0;
+    zmq_msg_t frame;
+
+    while (1) {
+        zmq_msg_init(&frame);
+        if (zmq_msg_recv(&frame, upstream, 0) == -1) {
+            zmq_msg_close(&frame);
+            return -1;
+        }
+
+        size_t size = zmq_msg_size(&frame);
+        const char *data = zmq_msg_data(&frame);
+        if (part == 0) {
+            is_clock = size == strlen(MSG_CLOCK) && memcmp(data, MSG_CLOCK, size) == 0;
+            terminated = size == strlen(MSG_SERVER) && memcmp(data, MSG_SERVER, size) == 0;
+        } else if (part == 1 && is_clock && size == sizeof(uint64_t)) {
+            uint64_t stamp;
+            memcpy(&stamp, data, sizeof(stamp));
+            stats->lag_ms = ((double)now_us() - (double)stamp) / 1000.0;
+            if (stats->lag_ms > stats->max_lag_ms) stats->max_lag_ms = stats->lag_ms;
+        }
+
+        int more = zmq_msg_more(&frame);
+        stats->bytes += size;
+        if (zmq_msg_send(&frame, downstream, more ? ZMQ_SNDMORE : 0) == -1) {
+            zmq_msg_close(&frame);
+            return -1;
+        }
+        part++;
+        if (!more) break;
+    }
+
+    stats->messages++;
+    return terminated;
+}
+
+/**
+ * Forwards a subscription change from a downstream subscriber upstream.
+ *
+ * The relay keeps its own clock subscription, so unsubscriptions from the
+ * clock topic are not passed on.
+ *
+ * @param downstream XPUB socket subscribers connect to.
+ * @param upstream XSUB socket connected to the game server or parent relay.
+ * @param stats Pointer to the RelayStats to be updated.
+ * @return 0 on success, -1 on error.
+ */
+int forward_subscription(void *downstream, void *upstream, RelayStats *stats) {
+    char buffer[256];
+    int bytes = zmq_recv(downstream, buffer, sizeof(buffer), 0);
+    if (bytes == -1) return -1;
+    if (bytes > (int)sizeof(buffer)) bytes = sizeof(buffer);
+
+    if (bytes > 0 && buffer[0] == 0 && bytes - 1 == (int)strlen(MSG_CLOCK) &&
+        memcmp(buffer + 1, MSG_CLOCK, bytes - 1) == 0) {
+        return 0;
+    }
+
+    stats->subscriptions++;
+    return zmq_send(upstream, buffer, bytes, 0) == -1 ? -1 : 0;
+}
+
+/**
+ * Prints the throughput and lag of the last interval and resets the counters.
+ *
+ * @param stats Pointer to the RelayStats to be reported.
+ * @param seconds Length of the interval in seconds.
+ */
+void report_stats(RelayStats *stats, double seconds) {
+    printf("relay: %.1f msg/s, %.1f KiB/s, %llu subscription changes, lag %.1f ms (max %.1f ms)\n",
+           stats->messages / seconds, stats->bytes / seconds / 1024.0,
+           (unsigned long long)stats->subscriptions, stats->lag_ms, stats->max_lag_ms);
+    fflush(stdout);
+    *stats = (RelayStats){.lag_ms = stats->lag_ms};
+}
+
+/**
+ * Entry point for the spectator relay.
+ *
+ * The relay subscribes once to an upstream publisher (the game server or
+ * another relay) with an XSUB socket and republishes every message on an
+ * XPUB socket, so fan-out to many spectators costs the relay instead of the
+ * game server. Subscriptions from downstream are forwarded upstream, which
+ * keeps publisher-side filtering working through a tree of relays.
+ *
+ * Usage: space-relay [upstream-endpoint [bind-endpoints]]
+ *
+ * @return 0 upon completion, 1 on setup failure.
+ */
+int main(int argc, char *argv[]) {
+    const char *upstream_address = argc > 1 ? argv[1] : endpoint(ENV_RELAY_UPSTREAM, DEFAULT_PUBLISHER_ADDRESS);
+    const char *relay_address = argc > 2 ? argv[2] : endpoint(ENV_RELAY_ADDRESS, DEFAULT_RELAY_ADDRESS);
+
+    void *context = zmq_ctx_new();
+    if (!context) {
+        perror("Failed to create ZeroMQ context");
+        return 1;
+    }
+
+    void *upstream = zmq_socket(context, ZMQ_XSUB);
+    void *downstream = zmq_socket(context, ZMQ_XPUB);
+    if (!upstream || !downstream ||
+        zmq_connect(upstream, upstream_address) != 0 ||
+        attach_endpoints(downstream, relay_address, 1) != 0) {
+        perror("Failed to set up relay sockets");
+        if (upstream) zmq_close(upstream);
+        if (downstream) zmq_close(downstream);
+        zmq_ctx_destroy(context);
+        return 1;
+    }
+
+    // The relay's own subscription, used to measure lag
+    char clock_subscription[sizeof(MSG_CLOCK)];
+    clock_subscription[0] = 1;
+    memcpy(clock_subscription + 1, MSG_CLOCK, strlen(MSG_CLOCK));
+    zmq_send(upstream, clock_subscription, sizeof(clock_subscription), 0);
+
+    printf("relay: %s -> %s\n", upstream_address, relay_address);
+    fflush(stdout);
+
+    RelayStats stats = {0};
+    uint64_t last_report = now_us();
+    while (1) {
+        zmq_pollitem_t items[] = {{upstream, 0, ZMQ_POLLIN, 0}, {downstream, 0, ZMQ_POLLIN, 0}};
+        long timeout = RELAY_REPORT_SECONDS * 1000 - (long)((now_us() - last_report) / 1000);
+        if (zmq_poll(items, 2, timeout > 0 ? timeout : 0) == -1) {
+            perror("Failed to poll relay sockets");
+            break;
+        }
+
+        if (items[0].revents & ZMQ_POLLIN) {
+            int result = forward_message(upstream, downstream, &stats);
+            if (result == -1) {
+                perror("Failed to forward message");
+                break;
+            }
+            if (result == 1) {
+                break;
+            }
+        }
+
+        if ((items[1].revents & ZMQ_POLLIN) && forward_subscription(downstream, upstream, &stats) == -1) {
+            perror("Failed to forward subscription");
+            break;
+        }
+
+        uint64_t now = now_us();
+        if (now - last_report >= RELAY_REPORT_SECONDS * 1000000ULL) {
+            report_stats(&stats, (now - last_report) / 1e6);
+            last_report = now;
+        }
+    }
+
+    zmq_close(upstream);
+    zmq_close(downstream);
+    zmq_ctx_destroy(context);
+    return 0;
+}